@@ -0,0 +1,141 @@
+#include "batch.h"
+#include "binary.h"
+#include "board.h"
+#include "commands.h"
+#include <cstring>
+#include <thread>
+
+bool is_board_edge(const char *line, const size_t len) {
+  size_t start = 0;
+  while (start < len && line[start] == ' ') {
+    start++;
+  }
+  return len - start >= 3 && strncmp(line + start, "---", 3) == 0;
+}
+
+bool batch_read_job(InputBuffer &in, BatchJob &job) {
+  const char *line;
+  size_t len;
+  bool got_board = false;
+  while (in.next_line(line, len)) {
+    got_board = true;
+    job.input.append(line, len);
+    job.input += '\n';
+    if (is_board_edge(line, len)) {
+      break;
+    }
+  }
+  if (!got_board) {
+    return false;
+  }
+
+  while (in.next_line(line, len)) {
+    if (len > 0 && (line[0] == '-' || line[0] == ' ')) {
+      break;
+    }
+    job.input.append(line, len);
+    job.input += '\n';
+  }
+  return true;
+}
+
+void batch_write_jobs(BatchQueue &queue, OutputBuffer &out,
+                      const bool flush_each) {
+  while (true) {
+    std::shared_ptr<BatchJob> job;
+    {
+      std::unique_lock<std::mutex> lock(queue.mutex);
+      if (flush_each && !(!queue.jobs.empty() && queue.jobs.front()->done)) {
+        // nothing more to write right now, send what there is
+        lock.unlock();
+        out.flush();
+        lock.lock();
+      }
+      queue.cv.wait(lock, [&queue] {
+        return (!queue.jobs.empty() && queue.jobs.front()->done) ||
+               (queue.reading_done && queue.jobs.empty());
+      });
+      if (queue.jobs.empty()) {
+        break;
+      }
+      job = queue.jobs.front();
+      queue.jobs.pop_front();
+    }
+    // the reader may be waiting for room
+    queue.cv.notify_all();
+    out.write(job->output.data(), job->output.size());
+  }
+  out.flush();
+}
+
+void batch_submit(ThreadPool &pool, std::vector<Board> &boards,
+                  BatchQueue &queue, std::shared_ptr<BatchJob> job) {
+  job->done = false;
+  {
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    queue.cv.wait(lock,
+                  [&queue] { return queue.jobs.size() < BATCH_MAX_IN_FLIGHT; });
+    queue.jobs.push_back(job);
+  }
+
+  pool.submit([&boards, &queue, job](int w) {
+    InputBuffer job_in;
+    job_in.open_memory(job->input.data(), job->input.size());
+    OutputBuffer job_out(-1);
+    if (job->binary) {
+      run_binary_once(boards[w], job_in, job_out);
+    } else {
+      run_once(boards[w], job_in, job_out);
+    }
+
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    job->output.swap(job_out.data);
+    job->done = true;
+    queue.cv.notify_all();
+  });
+}
+
+void batch_reading_done(BatchQueue &queue) {
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.reading_done = true;
+  }
+  queue.cv.notify_all();
+}
+
+void run_batch(InputBuffer &in, OutputBuffer &out, const int threads,
+               ResultCache *cache, const SolutionTable *solutions,
+               const bool binary) {
+  ThreadPool pool(threads);
+  std::vector<Board> boards(threads);
+  for (Board &board : boards) {
+    board.cache = cache;
+    board.solutions = solutions;
+  }
+
+  BatchQueue queue;
+  queue.reading_done = false;
+  std::thread writer(batch_write_jobs, std::ref(queue), std::ref(out), false);
+
+  if (!binary) {
+    // skip ---
+    const char *line;
+    size_t len;
+    in.next_line(line, len);
+  }
+
+  while (true) {
+    std::shared_ptr<BatchJob> job(new BatchJob());
+    job->binary = binary;
+    bool got_job = binary ? binary_read_record(in, job->input)
+                          : batch_read_job(in, *job);
+    if (!got_job) {
+      break;
+    }
+    batch_submit(pool, boards, queue, job);
+  }
+
+  pool.wait();
+  batch_reading_done(queue);
+  writer.join();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "board.h"
+#include "cache.h"
+#include "io.h"
+#include "thread_pool.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// boards read but not written yet, bounds memory use on huge inputs
+#define BATCH_MAX_IN_FLIGHT 1024
+
+// one board with its queries
+struct BatchJob {
+  std::string input;
+  std::vector<char> output;
+  bool done;
+  // input is a record of the binary format instead of text
+  bool binary;
+};
+
+struct BatchQueue {
+  std::mutex mutex;
+  std::condition_variable cv;
+  // in input order, the writer takes finished jobs from the front
+  std::deque<std::shared_ptr<BatchJob>> jobs;
+  bool reading_done;
+};
+
+// top and bottom lines of a board, "---" after some spaces
+bool is_board_edge(const char *line, const size_t len);
+// reads the next text board and its queries into job
+// the top line of the board has to be consumed already, like for
+// Board::parse, and the top line of the next board is consumed here
+bool batch_read_job(InputBuffer &in, BatchJob &job);
+// queues job, waiting while the queue is full, and answers it on the
+// pool with the board of the worker
+void batch_submit(ThreadPool &pool, std::vector<Board> &boards,
+                  BatchQueue &queue, std::shared_ptr<BatchJob> job);
+// no more jobs are coming
+void batch_reading_done(BatchQueue &queue);
+// writes the answers in queue order until reading is done and every job
+// is written, flush_each sends them as soon as the writer catches up
+void batch_write_jobs(BatchQueue &queue, OutputBuffer &out,
+                      const bool flush_each);
+
+// answers every board of in on `threads` workers
+// a reader splits the input at the "---" board boundaries, every worker
+// owns a Board, and a writer prints the answers in input order
+// cache and solutions may be null, binary input has its header consumed
+// already
+void run_batch(InputBuffer &in, OutputBuffer &out, const int threads,
+               ResultCache *cache, const SolutionTable *solutions,
+               const bool binary);
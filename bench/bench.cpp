@@ -0,0 +1,278 @@
+#include "board.h"
+#include "commands.h"
+#include "io.h"
+#include "parallel_search.h"
+#include "positions.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// fills of the generated boards, in turn
+static const double FILLS[] = {0.0, 0.1, 0.2, 0.3, 0.4,
+                               0.5, 0.6, 0.7, 0.8, 0.9};
+#define FILL_COUNT (sizeof(FILLS) / sizeof(FILLS[0]))
+
+// every command of command() but GENMOVE, see time_playouts; the ones
+// with an argument at a fixed one
+static const char *COMMANDS[] = {
+    "BOARD_SIZE",
+    "PAWNS_NUMBER",
+    "IS_BOARD_CORRECT",
+    "IS_GAME_OVER",
+    "IS_BOARD_POSSIBLE",
+    "WINNING_MOVES_RED",
+    "WINNING_MOVES_BLUE",
+    "COUNT_POSITIONS 2",
+    "CAN_RED_WIN_IN_1_MOVE_WITH_NAIVE_OPPONENT",
+    "CAN_BLUE_WIN_IN_1_MOVE_WITH_NAIVE_OPPONENT",
+    "CAN_RED_WIN_IN_1_MOVE_WITH_PERFECT_OPPONENT",
+    "CAN_BLUE_WIN_IN_1_MOVE_WITH_PERFECT_OPPONENT",
+    "CAN_RED_WIN_IN_2_MOVES_WITH_NAIVE_OPPONENT",
+    "CAN_BLUE_WIN_IN_2_MOVES_WITH_NAIVE_OPPONENT",
+    "CAN_RED_WIN_IN_2_MOVES_WITH_PERFECT_OPPONENT",
+    "CAN_BLUE_WIN_IN_2_MOVES_WITH_PERFECT_OPPONENT",
+};
+#define COMMAND_COUNT (sizeof(COMMANDS) / sizeof(COMMANDS[0]))
+
+// playouts of every GENMOVE of the engine benchmark
+#define GENMOVE_PLAYOUTS 2000
+
+struct Result {
+  const char *command;
+  int size;
+  int boards;
+  double median_ns;
+  double p99_ns;
+  double boards_per_sec;
+};
+
+static void parse_board(Board &board, const std::string &text) {
+  InputBuffer in;
+  in.open_memory(text.data(), text.size());
+  const char *line;
+  size_t len;
+  // skip ---
+  in.next_line(line, len);
+  board.parse(in);
+}
+
+// every board is parsed again before it is timed, so no command sees
+// what an earlier one cached
+static Result time_command(Board &board, const char *cmd, const int size,
+                           const std::vector<std::string> &positions) {
+  OutputBuffer out(-1);
+  std::vector<double> times;
+  double total_ns = 0;
+
+  for (const std::string &text : positions) {
+    parse_board(board, text);
+
+    auto start = std::chrono::steady_clock::now();
+    command(board, cmd, out);
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    times.push_back(ns);
+    total_ns += ns;
+    out.data.clear();
+  }
+
+  std::sort(times.begin(), times.end());
+  int n = times.size();
+  Result result;
+  result.command = cmd;
+  result.size = size;
+  result.boards = n;
+  result.median_ns = times[n / 2];
+  // the smallest time that at least 99% of the boards do not exceed
+  result.p99_ns = times[std::min(n - 1, (99 * n + 99) / 100 - 1)];
+  result.boards_per_sec = total_ns > 0 ? n / (total_ns * 1e-9) : 0;
+  return result;
+}
+
+struct PlayoutResult {
+  int size;
+  int boards;
+  uint64_t playouts;
+  double playouts_per_sec;
+};
+
+// engine throughput, GENMOVE for the side to move on every board
+static PlayoutResult time_playouts(Board &board, const int size,
+                                   const std::vector<std::string> &positions) {
+  PlayoutResult result;
+  result.size = size;
+  result.boards = positions.size();
+  result.playouts = 0;
+  double total_ns = 0;
+
+  for (const std::string &text : positions) {
+    parse_board(board, text);
+
+    int played;
+    auto start = std::chrono::steady_clock::now();
+    board.genmove(board.curr_turn(), GENMOVE_PLAYOUTS, 0, played);
+    auto end = std::chrono::steady_clock::now();
+
+    total_ns += std::chrono::duration<double, std::nano>(end - start).count();
+    result.playouts += played;
+  }
+  result.playouts_per_sec =
+      total_ns > 0 ? result.playouts / (total_ns * 1e-9) : 0;
+  return result;
+}
+
+static void write_results(FILE *file, const char *label, const uint64_t seed,
+                          const int per_size, const int threads,
+                          const std::vector<Result> &results,
+                          const std::vector<PlayoutResult> &playouts) {
+  fprintf(file, "{\n");
+  fprintf(file, "  \"label\": \"%s\",\n", label);
+  fprintf(file, "  \"seed\": %llu,\n", (unsigned long long)seed);
+  fprintf(file, "  \"boards_per_size\": %d,\n", per_size);
+  fprintf(file, "  \"threads\": %d,\n", threads);
+  fprintf(file, "  \"results\": [\n");
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result &r = results[i];
+    fprintf(file,
+            "    {\"command\": \"%s\", \"size\": %d, \"boards\": %d, "
+            "\"median_ns\": %.0f, \"p99_ns\": %.0f, "
+            "\"boards_per_sec\": %.1f}%s\n",
+            r.command, r.size, r.boards, r.median_ns, r.p99_ns,
+            r.boards_per_sec, i + 1 < results.size() ? "," : "");
+  }
+  fprintf(file, "  ],\n");
+  fprintf(file, "  \"genmove\": [\n");
+  for (size_t i = 0; i < playouts.size(); i++) {
+    const PlayoutResult &r = playouts[i];
+    fprintf(file,
+            "    {\"size\": %d, \"boards\": %d, \"playouts\": %llu, "
+            "\"playouts_per_sec\": %.1f}%s\n",
+            r.size, r.boards, (unsigned long long)r.playouts,
+            r.playouts_per_sec, i + 1 < playouts.size() ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+}
+
+// the corpus in the input format, every command after every board
+static void write_corpus(FILE *file,
+                         const std::vector<std::string> (&positions)[MAX_SIZE +
+                                                                      1]) {
+  for (int size = 1; size <= MAX_SIZE; size++) {
+    for (const std::string &text : positions[size]) {
+      fputs(text.c_str(), file);
+      for (const char *cmd : COMMANDS) {
+        fprintf(file, "%s\n", cmd);
+      }
+      fputc('\n', file);
+    }
+  }
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [-n boards per size] [-s seed] [-o results.json] "
+          "[-l label] [-d corpus.txt] [-t threads]\n",
+          name);
+}
+
+int main(int argc, char **argv) {
+  int per_size = 20;
+  uint64_t seed = 1;
+  const char *results_path = nullptr;
+  const char *corpus_path = nullptr;
+  const char *label = "";
+  int threads = 1;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) {
+      usage(argv[0]);
+      return 1;
+    }
+    if (strcmp(argv[i], "-n") == 0) {
+      per_size = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-s") == 0) {
+      seed = strtoull(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "-o") == 0) {
+      results_path = argv[++i];
+    } else if (strcmp(argv[i], "-l") == 0) {
+      label = argv[++i];
+    } else if (strcmp(argv[i], "-d") == 0) {
+      corpus_path = argv[++i];
+    } else if (strcmp(argv[i], "-t") == 0) {
+      // CAN_* and GENMOVE searches split across threads
+      threads = atoi(argv[++i]);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (per_size <= 0 || threads <= 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  PositionGenerator generator(seed);
+  std::vector<std::string> positions[MAX_SIZE + 1];
+  for (int size = 1; size <= MAX_SIZE; size++) {
+    for (int i = 0; i < per_size; i++) {
+      positions[size].push_back(
+          generator.generate(size, FILLS[i % FILL_COUNT]));
+    }
+  }
+
+  if (corpus_path != nullptr) {
+    FILE *file = fopen(corpus_path, "w");
+    if (file == nullptr) {
+      fprintf(stderr, "can not open %s\n", corpus_path);
+      return 1;
+    }
+    write_corpus(file, positions);
+    fclose(file);
+  }
+
+  Board board;
+  std::unique_ptr<ParallelSearch> parallel;
+  if (threads > 1) {
+    parallel.reset(new ParallelSearch(threads));
+    board.parallel = parallel.get();
+  }
+  std::vector<Result> results;
+  printf("%-46s %4s %12s %12s %14s\n", "command", "size", "median us",
+         "p99 us", "boards/s");
+  for (const char *cmd : COMMANDS) {
+    for (int size = 1; size <= MAX_SIZE; size++) {
+      Result r = time_command(board, cmd, size, positions[size]);
+      printf("%-46s %4d %12.2f %12.2f %14.1f\n", r.command, r.size,
+             r.median_ns / 1000, r.p99_ns / 1000, r.boards_per_sec);
+      fflush(stdout);
+      results.push_back(r);
+    }
+  }
+
+  std::vector<PlayoutResult> playouts;
+  printf("\n%-46s %4s %12s %12s\n", "GENMOVE", "size", "playouts",
+         "playouts/s");
+  for (int size = 1; size <= MAX_SIZE; size++) {
+    PlayoutResult r = time_playouts(board, size, positions[size]);
+    printf("%-46s %4d %12llu %12.1f\n", "", r.size,
+           (unsigned long long)r.playouts, r.playouts_per_sec);
+    fflush(stdout);
+    playouts.push_back(r);
+  }
+
+  if (results_path != nullptr) {
+    FILE *file = fopen(results_path, "w");
+    if (file == nullptr) {
+      fprintf(stderr, "can not open %s\n", results_path);
+      return 1;
+    }
+    write_results(file, label, seed, per_size, threads, results, playouts);
+    fclose(file);
+  }
+  return 0;
+}
@@ -0,0 +1,59 @@
+#include "positions.h"
+#include "io.h"
+
+// random boards are thrown away until one is possible, after this many
+// tries in a row one stone less is placed
+#define TRIES_PER_COUNT 64
+
+PositionGenerator::PositionGenerator(const uint64_t seed) : state(seed) {}
+
+// splitmix64, unlike the std distributions it is the same everywhere
+uint64_t PositionGenerator::next() {
+  uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+int PositionGenerator::next_below(const int bound) {
+  return next() % bound;
+}
+
+std::string PositionGenerator::generate(const int size, const double fill) {
+  const int cell_count = size * size;
+  int stones = fill * cell_count;
+  char cells[MAX_CELLS];
+  int order[MAX_CELLS];
+
+  for (int tries = 1;; tries++) {
+    for (int id = 0; id < cell_count; id++) {
+      cells[id] = ' ';
+      order[id] = id;
+    }
+    // the first `stones` cells of a fisher-yates shuffle
+    for (int i = 0; i < stones; i++) {
+      int j = i + next_below(cell_count - i);
+      int id = order[j];
+      order[j] = order[i];
+      order[i] = id;
+      cells[id] = i % 2 == 0 ? 'r' : 'b';
+    }
+
+    std::string text = render_board(cells, size);
+    InputBuffer in;
+    in.open_memory(text.data(), text.size());
+    const char *line;
+    size_t len;
+    // skip ---
+    in.next_line(line, len);
+    board.parse(in);
+    if (board.is_board_possible()) {
+      return text;
+    }
+
+    // an empty board is always possible, so this ends
+    if (tries % TRIES_PER_COUNT == 0 && stones > 0) {
+      stones--;
+    }
+  }
+}
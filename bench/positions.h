@@ -0,0 +1,23 @@
+#pragma once
+
+#include "board.h"
+#include <cstdint>
+#include <string>
+
+// seeded source of legal positions, the same seed always gives the same
+// boards on every platform
+struct PositionGenerator {
+  uint64_t state;
+  // only used to check the generated positions
+  Board board;
+
+  PositionGenerator(const uint64_t seed);
+
+  uint64_t next();
+  // uniform in [0, bound)
+  int next_below(const int bound);
+
+  // a board with about fill * size * size stones that passes
+  // IS_BOARD_POSSIBLE, red and blue take turns placing them
+  std::string generate(const int size, const double fill);
+};
@@ -0,0 +1,356 @@
+#include "binary.h"
+#include "commands.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// text of the opcodes without arguments
+static const char *QUERY_LINES[QUERY_OPCODES] = {
+    nullptr,
+    "BOARD_SIZE",
+    "PAWNS_NUMBER",
+    "IS_BOARD_CORRECT",
+    "IS_GAME_OVER",
+    "IS_BOARD_POSSIBLE",
+    "WINNING_MOVES_RED",
+    "WINNING_MOVES_BLUE",
+};
+
+static bool is_can_opcode(const int opcode) {
+  return opcode >= QUERY_CAN_RED_NAIVE && opcode <= QUERY_CAN_BLUE_PERFECT;
+}
+
+static bool is_genmove_opcode(const int opcode) {
+  return opcode >= QUERY_GENMOVE_RED && opcode <= QUERY_GENMOVE_BLUE_MS;
+}
+
+// bytes of the argument after the opcode
+static int arg_len(const int opcode) {
+  if (is_genmove_opcode(opcode)) {
+    return 4;
+  }
+  return is_can_opcode(opcode) || opcode == QUERY_COUNT_POSITIONS ? 1 : 0;
+}
+
+bool binary_query_from_text(const char *line, BinaryQuery &query) {
+  query.arg = 0;
+  for (int opcode = 0; opcode < QUERY_OPCODES; opcode++) {
+    if (QUERY_LINES[opcode] != nullptr &&
+        strcmp(line, QUERY_LINES[opcode]) == 0) {
+      query.opcode = opcode;
+      return true;
+    }
+  }
+  if (string_startswith(line, "COUNT_POSITIONS ")) {
+    int depth;
+    if (!parse_count_positions(line, depth)) {
+      return false;
+    }
+    if (depth > 255) {
+      std::cerr << "too deep for the binary format: " << line << "\n";
+      return false;
+    }
+    query.opcode = QUERY_COUNT_POSITIONS;
+    query.arg = depth;
+    return true;
+  }
+  if (string_startswith(line, "GENMOVE ")) {
+    Player player;
+    int amount;
+    bool timed;
+    if (!parse_genmove(line, player, amount, timed)) {
+      return false;
+    }
+    query.opcode = player == RED ? (timed ? QUERY_GENMOVE_RED_MS
+                                          : QUERY_GENMOVE_RED)
+                                 : (timed ? QUERY_GENMOVE_BLUE_MS
+                                          : QUERY_GENMOVE_BLUE);
+    query.arg = amount;
+    return true;
+  }
+  if (!string_startswith(line, "CAN_")) {
+    return false;
+  }
+
+  Player player;
+  int moves;
+  bool perfect_op;
+  if (!parse_can_query(line, player, moves, perfect_op)) {
+    return false;
+  }
+  if (moves > 255) {
+    std::cerr << "too many moves for the binary format: " << line << "\n";
+    return false;
+  }
+  query.opcode = player == RED
+                     ? (perfect_op ? QUERY_CAN_RED_PERFECT : QUERY_CAN_RED_NAIVE)
+                     : (perfect_op ? QUERY_CAN_BLUE_PERFECT
+                                   : QUERY_CAN_BLUE_NAIVE);
+  query.arg = moves;
+  return true;
+}
+
+void binary_query_text(const BinaryQuery &query, char (&line)[MAX_LINE_LEN]) {
+  if (query.opcode == QUERY_COUNT_POSITIONS) {
+    snprintf(line, MAX_LINE_LEN, "COUNT_POSITIONS %u", query.arg);
+    return;
+  }
+  if (is_genmove_opcode(query.opcode)) {
+    bool red = query.opcode == QUERY_GENMOVE_RED ||
+               query.opcode == QUERY_GENMOVE_RED_MS;
+    bool timed = query.opcode == QUERY_GENMOVE_RED_MS ||
+                 query.opcode == QUERY_GENMOVE_BLUE_MS;
+    snprintf(line, MAX_LINE_LEN, "GENMOVE %s %u%s", red ? "RED" : "BLUE",
+             query.arg, timed ? "MS" : "");
+    return;
+  }
+  if (!is_can_opcode(query.opcode)) {
+    snprintf(line, MAX_LINE_LEN, "%s", QUERY_LINES[query.opcode]);
+    return;
+  }
+  bool red = query.opcode == QUERY_CAN_RED_NAIVE ||
+             query.opcode == QUERY_CAN_RED_PERFECT;
+  bool perfect_op = query.opcode == QUERY_CAN_RED_PERFECT ||
+                    query.opcode == QUERY_CAN_BLUE_PERFECT;
+  snprintf(line, MAX_LINE_LEN, "CAN_%s_WIN_IN_%d_%s_WITH_%s_OPPONENT",
+           red ? "RED" : "BLUE", query.arg,
+           query.arg == 1 ? "MOVE" : "MOVES",
+           perfect_op ? "PERFECT" : "NAIVE");
+}
+
+bool binary_detect(InputBuffer &in) {
+  return in.fill(BINARY_MAGIC_LEN) &&
+         memcmp(in.data + in.pos, BINARY_MAGIC, BINARY_MAGIC_LEN) == 0;
+}
+
+bool binary_read_header(InputBuffer &in) {
+  const char *bytes;
+  if (!in.next_bytes(bytes, BINARY_MAGIC_LEN + 1) ||
+      memcmp(bytes, BINARY_MAGIC, BINARY_MAGIC_LEN) != 0) {
+    std::cerr << "not a binary input\n";
+    return false;
+  }
+  int version = (uint8_t)bytes[BINARY_MAGIC_LEN];
+  if (version != BINARY_VERSION) {
+    std::cerr << "binary input of version " << version << ", expected "
+              << BINARY_VERSION << "\n";
+    return false;
+  }
+  return true;
+}
+
+static int packed_len(const int size) { return (size * size + 3) / 4; }
+
+// a record cut short is an error, like a parse error of the text
+static void truncated() {
+  std::cerr << "parse error: binary input ends inside a board\n";
+  exit(1);
+}
+
+void Board::unpack(const int new_size, const uint8_t *packed) {
+  reset();
+  size = new_size;
+  cells.resize(size * size);
+  for (int id = 0; id < size * size; id++) {
+    int value = (packed[id >> 2] >> ((id & 3) * 2)) & 3;
+    if (value > BLUE) {
+      std::cerr << "parse error: wrong player " << value << "\n";
+      exit(1);
+    }
+    cells[id] = (Player)value;
+    if (value == RED) {
+      red_count++;
+    } else if (value == BLUE) {
+      blue_count++;
+    }
+  }
+  update_from_cells();
+}
+
+bool binary_read_board(InputBuffer &in, Board &board) {
+  const char *bytes;
+  if (!in.next_bytes(bytes, 1)) {
+    return false;
+  }
+  int size = (uint8_t)bytes[0];
+  if (size > MAX_SIZE) {
+    std::cerr << "parse error: board larger than " << MAX_SIZE
+              << MAX_SIZE_HINT "\n";
+    exit(1);
+  }
+  if (!in.next_bytes(bytes, packed_len(size))) {
+    truncated();
+  }
+  board.unpack(size, (const uint8_t *)bytes);
+  return true;
+}
+
+bool binary_read_query(InputBuffer &in, BinaryQuery &query) {
+  const char *bytes;
+  if (!in.next_bytes(bytes, 1)) {
+    truncated();
+  }
+  query.opcode = bytes[0];
+  query.arg = 0;
+  if (query.opcode == QUERY_END) {
+    return false;
+  }
+  if (query.opcode >= QUERY_OPCODES) {
+    std::cerr << "parse error: unknown query opcode " << (int)query.opcode
+              << "\n";
+    exit(1);
+  }
+  int len = arg_len(query.opcode);
+  if (len > 0) {
+    if (!in.next_bytes(bytes, len)) {
+      truncated();
+    }
+    for (int i = len - 1; i >= 0; i--) {
+      query.arg = query.arg << 8 | (uint8_t)bytes[i];
+    }
+  }
+  return true;
+}
+
+bool binary_read_record(InputBuffer &in, std::string &raw) {
+  const char *bytes;
+  if (!in.next_bytes(bytes, 1)) {
+    return false;
+  }
+  int size = (uint8_t)bytes[0];
+  raw += bytes[0];
+  if (size > MAX_SIZE) {
+    std::cerr << "parse error: board larger than " << MAX_SIZE
+              << MAX_SIZE_HINT "\n";
+    return false;
+  }
+  if (!in.next_bytes(bytes, packed_len(size))) {
+    std::cerr << "parse error: binary input ends inside a board\n";
+    return false;
+  }
+  for (int id = 0; id < size * size; id++) {
+    if (((bytes[id >> 2] >> ((id & 3) * 2)) & 3) > BLUE) {
+      std::cerr << "parse error: wrong player\n";
+      return false;
+    }
+  }
+  raw.append(bytes, packed_len(size));
+
+  while (true) {
+    if (!in.next_bytes(bytes, 1)) {
+      std::cerr << "parse error: binary input ends inside a board\n";
+      return false;
+    }
+    int opcode = (uint8_t)bytes[0];
+    raw += bytes[0];
+    if (opcode == QUERY_END) {
+      return true;
+    }
+    if (opcode >= QUERY_OPCODES) {
+      std::cerr << "parse error: unknown query opcode " << opcode << "\n";
+      return false;
+    }
+    int len = arg_len(opcode);
+    if (len > 0) {
+      if (!in.next_bytes(bytes, len)) {
+        std::cerr << "parse error: binary input ends inside a board\n";
+        return false;
+      }
+      raw.append(bytes, len);
+    }
+  }
+}
+
+void binary_write_header(OutputBuffer &out) {
+  char header[BINARY_MAGIC_LEN + 1];
+  memcpy(header, BINARY_MAGIC, BINARY_MAGIC_LEN);
+  header[BINARY_MAGIC_LEN] = BINARY_VERSION;
+  out.write(header, sizeof(header));
+}
+
+void binary_write_board(OutputBuffer &out, const Board &board) {
+  char bytes[1 + (MAX_CELLS + 3) / 4];
+  memset(bytes, 0, sizeof(bytes));
+  bytes[0] = board.size;
+  for (int id = 0; id < board.size * board.size; id++) {
+    bytes[1 + (id >> 2)] |= board.cells[id] << ((id & 3) * 2);
+  }
+  out.write(bytes, 1 + packed_len(board.size));
+}
+
+void binary_write_query(OutputBuffer &out, const BinaryQuery &query) {
+  char bytes[5] = {(char)query.opcode};
+  for (int i = 0; i < 4; i++) {
+    bytes[1 + i] = query.arg >> (i * 8);
+  }
+  out.write(bytes, 1 + arg_len(query.opcode));
+}
+
+void binary_write_end(OutputBuffer &out) {
+  char end = QUERY_END;
+  out.write(&end, 1);
+}
+
+void convert_to_binary(InputBuffer &in, OutputBuffer &out) {
+  Board board;
+  binary_write_header(out);
+
+  // skip ---
+  const char *line;
+  size_t len;
+  in.next_line(line, len);
+
+  while (!in.at_end()) {
+    board.parse(in);
+    binary_write_board(out, board);
+
+    while (in.next_line(line, len)) {
+      if (len > 0 && (line[0] == '-' || line[0] == ' ')) {
+        // first line of the next board
+        break;
+      }
+      if (len == 0) {
+        continue;
+      }
+      if (len >= MAX_LINE_LEN) {
+        std::cerr << "Invalid command: line too long\n";
+        continue;
+      }
+      char buffer[MAX_LINE_LEN];
+      memcpy(buffer, line, len);
+      buffer[len] = '\0';
+      BinaryQuery query;
+      if (!binary_query_from_text(buffer, query)) {
+        std::cerr << "left out, no opcode for: " << buffer << "\n";
+        continue;
+      }
+      binary_write_query(out, query);
+    }
+    binary_write_end(out);
+  }
+}
+
+void convert_to_text(InputBuffer &in, OutputBuffer &out) {
+  Board board;
+  char cells[MAX_CELLS];
+  char line[MAX_LINE_LEN];
+
+  while (binary_read_board(in, board)) {
+    for (int id = 0; id < board.size * board.size; id++) {
+      cells[id] = board.cells[id] == RED    ? 'r'
+                  : board.cells[id] == BLUE ? 'b'
+                                            : ' ';
+    }
+    std::string text = render_board(cells, board.size);
+    out.write(text.data(), text.size());
+
+    BinaryQuery query;
+    while (binary_read_query(in, query)) {
+      binary_query_text(query, line);
+      out.write(line);
+      out.write("\n", 1);
+    }
+    out.write("\n", 1);
+  }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "board.h"
+#include "io.h"
+#include <cstdint>
+
+// compact input format, about a tenth of the text one
+//
+// "HEXB" and a version byte, then for every board:
+//   the size byte,
+//   size * size cells in row-major order, 2 bits each (NONE 0, RED 1,
+//   BLUE 2), the first cell in the low bits of the first byte, the last
+//   byte padded with zeros,
+//   its queries, an opcode byte each, CAN_* followed by a moves byte,
+//   COUNT_POSITIONS by a depth byte, GENMOVE_* by the playouts or
+//   milliseconds in 4 little-endian bytes,
+//   and QUERY_END
+#define BINARY_MAGIC "HEXB"
+#define BINARY_MAGIC_LEN 4
+#define BINARY_VERSION 1
+
+enum QueryOpcode {
+  QUERY_END,
+  QUERY_BOARD_SIZE,
+  QUERY_PAWNS_NUMBER,
+  QUERY_IS_BOARD_CORRECT,
+  QUERY_IS_GAME_OVER,
+  QUERY_IS_BOARD_POSSIBLE,
+  QUERY_WINNING_MOVES_RED,
+  QUERY_WINNING_MOVES_BLUE,
+  QUERY_CAN_RED_NAIVE,
+  QUERY_CAN_RED_PERFECT,
+  QUERY_CAN_BLUE_NAIVE,
+  QUERY_CAN_BLUE_PERFECT,
+  QUERY_COUNT_POSITIONS,
+  QUERY_GENMOVE_RED,
+  QUERY_GENMOVE_BLUE,
+  QUERY_GENMOVE_RED_MS,
+  QUERY_GENMOVE_BLUE_MS,
+  QUERY_OPCODES,
+};
+
+struct BinaryQuery {
+  uint8_t opcode;
+  // the moves of CAN_*, the depth of COUNT_POSITIONS, 0 to 255, or the
+  // amount of GENMOVE_*
+  uint32_t arg;
+};
+
+// false for lines that have no opcode, those are left out
+bool binary_query_from_text(const char *line, BinaryQuery &query);
+// the text line of the query, '\0' terminated
+void binary_query_text(const BinaryQuery &query, char (&line)[MAX_LINE_LEN]);
+
+// whether in starts with BINARY_MAGIC, nothing is consumed
+bool binary_detect(InputBuffer &in);
+// consumes the magic and the version, false for another version
+bool binary_read_header(InputBuffer &in);
+// the next board, false at the end of the input
+bool binary_read_board(InputBuffer &in, Board &board);
+// the next query of the board, false after its last one
+bool binary_read_query(InputBuffer &in, BinaryQuery &query);
+// appends the bytes of the next board and its queries to raw, checked
+// but not parsed; false at the end of the input, or (with a message) for
+// a cut off or broken record
+bool binary_read_record(InputBuffer &in, std::string &raw);
+
+void binary_write_header(OutputBuffer &out);
+void binary_write_board(OutputBuffer &out, const Board &board);
+void binary_write_query(OutputBuffer &out, const BinaryQuery &query);
+void binary_write_end(OutputBuffer &out);
+
+// the text input as binary, text lines that are not queries are dropped
+void convert_to_binary(InputBuffer &in, OutputBuffer &out);
+// the binary input, header consumed, as text
+void convert_to_text(InputBuffer &in, OutputBuffer &out);
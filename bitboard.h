@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cstdint>
+
+// the largest board of the build, `make big` sets it to 19
+// the limit is fixed at compile time: main stops at 11x11 and only the
+// separate main19 takes 12x12 to 19x19, nothing picks the wide Bitboard
+// by the size of the board at run time
+#ifndef MAX_SIZE
+#define MAX_SIZE 11
+#endif
+#define MAX_CELLS (MAX_SIZE * MAX_SIZE)
+
+// appended to the messages about a board past MAX_SIZE
+#if MAX_SIZE < 19
+#define MAX_SIZE_HINT ", make big builds main19 for boards up to 19x19"
+#else
+#define MAX_SIZE_HINT ""
+#endif
+
+// one bit per cell, bit id = row * size + col
+#if MAX_CELLS <= 128
+// 11 * 11 = 121 cells, so one 128-bit word is enough
+typedef unsigned __int128 Bitboard;
+#define BB_BITS 128
+
+inline Bitboard bb_bit(const int id) { return (Bitboard)1 << id; }
+
+inline bool bb_test(const Bitboard bb, const int id) {
+  return (bb >> id) & 1;
+}
+
+inline int bb_popcount(const Bitboard bb) {
+  return __builtin_popcountll((uint64_t)bb) +
+         __builtin_popcountll((uint64_t)(bb >> 64));
+}
+
+// lowest set cell, bb must not be empty
+inline int bb_first(const Bitboard bb) {
+  uint64_t low = (uint64_t)bb;
+  return low != 0 ? __builtin_ctzll(low)
+                  : 64 + __builtin_ctzll((uint64_t)(bb >> 64));
+}
+#else
+// larger boards take several words, with the operators of an integer so
+// the code above it is the same for both
+// a separate build, a wider type would slow down the small boards
+#define BB_WORDS ((MAX_CELLS + 63) / 64)
+#define BB_BITS (BB_WORDS * 64)
+
+struct Bitboard {
+  uint64_t w[BB_WORDS];
+
+  constexpr Bitboard() : w{} {}
+  // only for small constants, 0, 1 and ~0
+  constexpr Bitboard(const int value) : w{} {
+    for (int i = 0; i < BB_WORDS; i++) {
+      w[i] = value < 0 ? ~(uint64_t)0 : 0;
+    }
+    w[0] = (uint64_t)(int64_t)value;
+  }
+
+  constexpr explicit operator bool() const {
+    for (int i = 0; i < BB_WORDS; i++) {
+      if (w[i] != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  constexpr Bitboard &operator&=(const Bitboard &other) {
+    for (int i = 0; i < BB_WORDS; i++) {
+      w[i] &= other.w[i];
+    }
+    return *this;
+  }
+  constexpr Bitboard &operator|=(const Bitboard &other) {
+    for (int i = 0; i < BB_WORDS; i++) {
+      w[i] |= other.w[i];
+    }
+    return *this;
+  }
+  constexpr Bitboard &operator^=(const Bitboard &other) {
+    for (int i = 0; i < BB_WORDS; i++) {
+      w[i] ^= other.w[i];
+    }
+    return *this;
+  }
+};
+
+constexpr Bitboard operator&(Bitboard a, const Bitboard &b) { return a &= b; }
+constexpr Bitboard operator|(Bitboard a, const Bitboard &b) { return a |= b; }
+constexpr Bitboard operator^(Bitboard a, const Bitboard &b) { return a ^= b; }
+
+constexpr Bitboard operator~(Bitboard a) {
+  for (int i = 0; i < BB_WORDS; i++) {
+    a.w[i] = ~a.w[i];
+  }
+  return a;
+}
+
+constexpr bool operator==(const Bitboard &a, const Bitboard &b) {
+  for (int i = 0; i < BB_WORDS; i++) {
+    if (a.w[i] != b.w[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+constexpr bool operator!=(const Bitboard &a, const Bitboard &b) {
+  return !(a == b);
+}
+
+// for bb & (bb - 1), drops the lowest cell
+constexpr Bitboard operator-(Bitboard a, const Bitboard &b) {
+  uint64_t borrow = 0;
+  for (int i = 0; i < BB_WORDS; i++) {
+    uint64_t diff = a.w[i] - b.w[i] - borrow;
+    borrow = a.w[i] < b.w[i] || (a.w[i] == b.w[i] && borrow) ? 1 : 0;
+    a.w[i] = diff;
+  }
+  return a;
+}
+
+constexpr Bitboard operator<<(const Bitboard &a, const int n) {
+  Bitboard out;
+  const int words = n / 64;
+  const int bits = n % 64;
+  for (int i = BB_WORDS - 1; i >= words; i--) {
+    out.w[i] = a.w[i - words] << bits;
+    if (bits != 0 && i - words > 0) {
+      out.w[i] |= a.w[i - words - 1] >> (64 - bits);
+    }
+  }
+  return out;
+}
+
+constexpr Bitboard operator>>(const Bitboard &a, const int n) {
+  Bitboard out;
+  const int words = n / 64;
+  const int bits = n % 64;
+  for (int i = 0; i + words < BB_WORDS; i++) {
+    out.w[i] = a.w[i + words] >> bits;
+    if (bits != 0 && i + words + 1 < BB_WORDS) {
+      out.w[i] |= a.w[i + words + 1] << (64 - bits);
+    }
+  }
+  return out;
+}
+
+constexpr Bitboard bb_bit(const int id) {
+  Bitboard bb;
+  bb.w[id / 64] = (uint64_t)1 << (id % 64);
+  return bb;
+}
+
+inline bool bb_test(const Bitboard &bb, const int id) {
+  return (bb.w[id / 64] >> (id % 64)) & 1;
+}
+
+inline int bb_popcount(const Bitboard &bb) {
+  int count = 0;
+  for (int i = 0; i < BB_WORDS; i++) {
+    count += __builtin_popcountll(bb.w[i]);
+  }
+  return count;
+}
+
+// lowest set cell, bb must not be empty
+inline int bb_first(const Bitboard &bb) {
+  int i = 0;
+  while (bb.w[i] == 0) {
+    i++;
+  }
+  return i * 64 + __builtin_ctzll(bb.w[i]);
+}
+#endif
+
+// masks that depend only on the board size
+struct BoardMasks {
+  int size;
+  Bitboard all;
+  // used to cut off bits that wrapped around to the next / previous row
+  Bitboard not_first_col;
+  Bitboard not_last_col;
+
+  Bitboard red_start, red_dest;
+  Bitboard blue_start, blue_dest;
+
+  void init(const int new_size) {
+    size = new_size;
+    all = 0;
+    red_start = red_dest = blue_start = blue_dest = 0;
+    for (int row = 0; row < size; row++) {
+      for (int col = 0; col < size; col++) {
+        Bitboard bit = bb_bit(row * size + col);
+        all |= bit;
+        if (col == 0)
+          red_start |= bit;
+        if (col == size - 1)
+          red_dest |= bit;
+        if (row == 0)
+          blue_start |= bit;
+        if (row == size - 1)
+          blue_dest |= bit;
+      }
+    }
+    not_first_col = all & ~red_start;
+    not_last_col = all & ~red_dest;
+  }
+};
+
+// all cells adjacent to any cell of bb, same six directions as
+// Board::neighbors: (0, +-1), (+-1, 0), (+1, +1), (-1, -1)
+inline Bitboard bb_expand(const Bitboard bb, const BoardMasks &m) {
+  const int size = m.size;
+  Bitboard out = ((bb << 1) & m.not_first_col) | ((bb >> 1) & m.not_last_col) |
+                 (bb << size) | (bb >> size) |
+                 ((bb << (size + 1)) & m.not_first_col) |
+                 ((bb >> (size + 1)) & m.not_last_col);
+  return out & m.all;
+}
+
+// every cell of own reachable from seed through own cells
+inline Bitboard bb_flood(const Bitboard seed, const Bitboard own,
+                         const BoardMasks &m) {
+  Bitboard reach = seed & own;
+  while (true) {
+    Bitboard next = (reach | bb_expand(reach, m)) & own;
+    if (next == reach) {
+      return reach;
+    }
+    reach = next;
+  }
+}
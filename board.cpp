@@ -1,4 +1,6 @@
 #include "board.h"
+#include "kernels.h"
+#include "solutions.h"
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
@@ -6,8 +8,6 @@
 #include <iostream>
 #include <vector>
 
-#define MAX_LINE_LEN 70
-
 Player opposite_player(Player player) {
   if (player == RED) {
     return BLUE;
@@ -18,15 +18,57 @@ Player opposite_player(Player player) {
   return NONE;
 }
 
+static std::atomic<int> next_board_id(0);
+
 Board::Board()
-    : size(0), cells({}), red_count(0), blue_count(0), created_visited(false),
-      created_moves(false) {}
+    : size(0), board_id(0), cells({}), red_count(0), blue_count(0),
+      red_bits(0), blue_bits(0), hash(0), kernels(kernels_for_size(0)),
+      created_visited(false),
+      created_moves(false), created_uf(false), created_canonical_key(false),
+      parallel(nullptr), cache(nullptr), solutions(nullptr),
+      abort_flag(nullptr) {
+  // sized for the largest board up front, so parsing and searching
+  // never have to grow them
+  cells.reserve(MAX_CELLS);
+  sensible_moves.reserve(MAX_CELLS);
+  sensible_bits = 0;
+  naive_op_moves.reserve(MAX_CELLS);
+  player_moves.reserve(MAX_CELLS);
+  memset(padded, BORDER_OUTSIDE, sizeof(padded));
+  uf.init(PAD_CELLS);
+}
 
-Board::Board(const Board &other) {
+Board::Board(const Board &other)
+    : parallel(nullptr), cache(nullptr), solutions(nullptr),
+      abort_flag(nullptr) {
+  copy_position(other);
+}
+
+void Board::copy_position(const Board &other) {
   size = other.size;
+  board_id = other.board_id;
   cells = other.cells;
+  memcpy(padded, other.padded, sizeof(padded));
   red_count = other.red_count;
   blue_count = other.blue_count;
+  red_bits = other.red_bits;
+  blue_bits = other.blue_bits;
+  hash = other.hash;
+  masks = other.masks;
+  kernels = other.kernels;
+
+  red_connected = other.red_connected;
+  blue_connected = other.blue_connected;
+  created_visited = other.created_visited;
+
+  created_moves = other.created_moves;
+  sensible_moves = other.sensible_moves;
+  naive_op_moves = other.naive_op_moves;
+  player_moves = other.player_moves;
+  sensible_bits = other.sensible_bits;
+
+  created_uf = false;
+  created_canonical_key = false;
 }
 
 void Board::create_moves() {
@@ -41,6 +83,7 @@ void Board::create_moves() {
     }
     if (sensible_move(i)) {
       sensible_moves.push_back(i);
+      sensible_bits |= bb_bit(i);
       player_moves.push_back(i);
     } else {
       naive_op_moves.push_back(i);
@@ -58,44 +101,65 @@ void Board::create_visited() {
   if (created_visited) {
     return;
   }
-  base_visited.resize(size * size, false);
   created_visited = true;
 
-  red_connected = is_player_connected_with_visited(RED, base_visited);
-  blue_connected = is_player_connected_with_visited(BLUE, base_visited);
+  if (USE_BITBOARD) {
+    red_connected = is_player_connected_bits(RED);
+    blue_connected = is_player_connected_bits(BLUE);
+    return;
+  }
+  VisitedSet &visited = scratch.visited[0];
+  visited.clear();
+  red_connected = is_player_connected_with_visited(RED, visited);
+  blue_connected = is_player_connected_with_visited(BLUE, visited);
 }
 
 void Board::reset() {
+  board_id = ++next_board_id;
   red_count = 0;
   blue_count = 0;
   created_moves = false;
   sensible_moves.clear();
   naive_op_moves.clear();
+  player_moves.clear();
+  sensible_bits = 0;
 
   created_visited = false;
+  created_uf = false;
+  created_canonical_key = false;
+  tt.clear();
+  ordering.clear();
+}
+
+static bool line_equals(const char *line, const size_t len,
+                        const char *str) {
+  return len == strlen(str) && strncmp(line, str, len) == 0;
 }
 
 // assumes first line "---" is consumed
-void Board::parse_from_stdin() {
+// cells are parsed in place from the input lines, nothing is allocated
+// once cells has grown to MAX_CELLS
+void Board::parse(InputBuffer &in) {
   reset();
 
-  std::vector<Player> new_cells;
-  char buffer[MAX_LINE_LEN];
+  Player new_cells[MAX_CELLS];
+  int new_cells_count = 0;
 
-  std::cin.getline(buffer, sizeof(buffer));
-  while (strcmp(buffer, " ---") != 0) {
-    int len = strlen(buffer);
+  const char *line;
+  size_t len;
+  while (in.next_line(line, len) && !line_equals(line, len, " ---")) {
     int cell_count = 0;
 
-    for (int i = 0; i < len; i++) {
-      if (buffer[i] != '<') {
+    for (size_t i = 0; i < len; i++) {
+      if (line[i] != '<') {
         continue;
       }
       // skip "< "
       i += 2;
       Player p = NONE;
+      char c = i < len ? line[i] : '\0';
 
-      switch (buffer[i]) {
+      switch (c) {
       case 'r':
         p = RED;
         red_count++;
@@ -108,22 +172,28 @@ void Board::parse_from_stdin() {
         p = NONE;
         break;
       default:
-        std::cout << "parse error: wrong player '" << p << "'\n";
+        std::cerr << "parse error: wrong player '" << c << "'\n";
         exit(1);
         break;
       }
-      new_cells.push_back(p);
+      if (new_cells_count == MAX_CELLS) {
+        std::cerr << "parse error: board larger than " << MAX_SIZE
+                  << MAX_SIZE_HINT "\n";
+        exit(1);
+      }
+      new_cells[new_cells_count++] = p;
       cell_count++;
     }
 
-    std::cin.getline(buffer, sizeof(buffer));
-    if (new_cells.size() > 1 && cell_count == 1) {
+    if (new_cells_count > 1 && cell_count == 1) {
+      // skip the bottom "---"
+      in.next_line(line, len);
       break;
     }
   }
 
-  cells.resize(new_cells.size());
-  size = sqrt(new_cells.size());
+  cells.resize(new_cells_count);
+  size = sqrt(new_cells_count);
 
   int max_depth = 2 * (size - 1);
   int id = 0;
@@ -144,160 +214,214 @@ void Board::parse_from_stdin() {
       id++;
     }
   }
-}
 
-int Board::player_count(const Player player) {
-  assert(player != NONE);
-  return player == RED ? red_count : blue_count;
+  update_from_cells();
 }
-int Board::is_id_dest_side(const int id, const Player player) {
-  int col = id % size;
-  int row = id / size;
 
-  if (player == RED) {
-    return col == size - 1;
+void Board::update_from_cells() {
+  memset(padded, BORDER_OUTSIDE, sizeof(padded));
+  for (int i = 0; i < size; i++) {
+    padded[pad_pos(i, -1)] = BORDER_RED_START;
+    padded[pad_pos(i, size)] = BORDER_RED_DEST;
+    padded[pad_pos(-1, i)] = BORDER_BLUE_START;
+    padded[pad_pos(size, i)] = BORDER_BLUE_DEST;
+  }
+  for (int i = 0; i < size * size; i++) {
+    padded[pad_pos(i / size, i % size)] = cells[i];
+  }
+
+  masks.init(size);
+  kernels = kernels_for_size(size);
+  red_bits = 0;
+  blue_bits = 0;
+  hash = 0;
+  for (int i = 0; i < size * size; i++) {
+    if (cells[i] != NONE) {
+      player_bits(cells[i]) |= bb_bit(i);
+      hash ^= zobrist_cell(i, cells[i]);
+    }
   }
-  return row == size - 1;
 }
-int Board::is_id_start_side(const int id, const Player player) {
-  int col = id % size;
-  int row = id / size;
-  if (player == RED) {
-    return col == 0;
+
+void Board::set_cell(const int id, const Player player) {
+  Player prev = cells[id];
+  if (prev != NONE) {
+    player_bits(prev) &= ~bb_bit(id);
+    hash ^= zobrist_cell(id, prev);
+  }
+  if (player != NONE) {
+    player_bits(player) |= bb_bit(id);
+    hash ^= zobrist_cell(id, player);
   }
-  return row == 0;
+  cells[id] = player;
+  padded[pad_index(id)] = player;
+}
+
+Bitboard &Board::player_bits(const Player player) {
+  assert(player != NONE);
+  return player == RED ? red_bits : blue_bits;
+}
+
+int Board::player_count(const Player player) {
+  assert(player != NONE);
+  return player == RED ? red_count : blue_count;
 }
 bool Board::is_pos_valid(const int row, const int col) {
   return row >= 0 && row < size && col >= 0 && col < size;
 }
 int Board::neighbors(const int id, int (&arr_out)[6]) {
-  int count = 0;
-  int col = id % size;
-  int row = id / size;
-  if (is_pos_valid(row, col + 1)) {
-    arr_out[count] = id + 1;
-    count++;
-  }
-  if (is_pos_valid(row, col - 1)) {
-    arr_out[count] = id - 1;
-    count++;
-  }
-  if (is_pos_valid(row + 1, col)) {
-    arr_out[count] = id + size;
-    count++;
-  }
-  if (is_pos_valid(row - 1, col)) {
-    arr_out[count] = id - size;
-    count++;
-  }
-  if (is_pos_valid(row + 1, col + 1)) {
-    arr_out[count] = id + size + 1;
-    count++;
-  }
-  if (is_pos_valid(row - 1, col - 1)) {
-    arr_out[count] = id - size - 1;
-    count++;
-  }
-  return count;
+  return kernels->neighbors(id, arr_out);
 }
+int Board::pad_index(const int id) { return kernels->to_padded[id]; }
 bool Board::is_player_connected(const Player player) {
   create_visited();
   return player == RED ? red_connected : blue_connected;
 }
 
-bool Board::is_player_connected_with_visited(const Player player,
-                                             std::vector<bool> &visited) {
+bool Board::is_player_connected_bits(const Player player) {
   assert(player != NONE);
-  if (size == 1) {
-    return cells[0] == player;
+  if (USE_STATS) {
+    stats.flood_fills++;
   }
-  std::vector<int> id_stack;
-  id_stack.reserve(player_count(player));
+  return kernels->connected(player_bits(player), player);
+}
 
-  for (int i = 0; i < size; i++) {
-    int row, col;
-    if (player == RED) {
-      col = 0;
-      row = i;
-    } else {
-      col = i;
-      row = 0;
-    }
-    int id = row * size + col;
+bool Board::is_player_connected_with_visited(const Player player,
+                                             VisitedSet &visited) {
+  assert(player != NONE);
+  int *pos_stack = scratch.stacks[0];
 
-    if (cells[id] != player) {
+  for (int i = 0; i < size; i++) {
+    int pos = player == RED ? pad_pos(i, 0) : pad_pos(0, i);
+    if (padded[pos] != player || visited.test(pos)) {
       continue;
     }
 
-    if (is_player_connected_from_start(player, id, visited, id_stack))
+    if (is_player_connected_from_start(player, pos, visited, pos_stack))
       return true;
   }
   return false;
 }
 
-bool Board::is_player_connected_from_start(const Player player, const int id,
-                                           std::vector<bool> &visited,
-                                           std::vector<int> &id_stack) {
-  visited[id] = true;
-  id_stack.push_back(id);
-
-  while (!id_stack.empty()) {
-    int id = id_stack.back();
-    id_stack.pop_back();
-
-    if (is_id_dest_side(id, player)) {
-      return true;
+// walks padded, so reaching the destination is just seeing its border
+bool Board::is_player_connected_from_start(const Player player, const int pos,
+                                           VisitedSet &visited,
+                                           int *pos_stack) {
+  const uint8_t dest = border_dest(player);
+  visited.set(pos);
+  int top = 0;
+  pos_stack[top++] = pos;
+  if (USE_STATS) {
+    stats.dfs_calls++;
+  }
+
+  while (top > 0) {
+    int curr = pos_stack[--top];
+    if (USE_STATS) {
+      stats.dfs_expanded++;
     }
 
-    int adj[6];
-    int n_count = neighbors(id, adj);
-    for (int i = 0; i < n_count; i++) {
-      int n = adj[i];
-      if (visited[n] || cells[n] != player) {
+    for (int offset : PAD_OFFSETS) {
+      int n = curr + offset;
+      if (padded[n] == dest) {
+        if (USE_STATS) {
+          stats.dfs_early_exits++;
+        }
+        return true;
+      }
+      if (padded[n] != player || visited.test(n)) {
         continue;
       }
 
-      visited[n] = true;
-      id_stack.push_back(n);
+      visited.set(n);
+      pos_stack[top++] = n;
     }
   }
 
   return false;
 }
-bool Board::is_player_connected_partial(const Player player, const int id,
-                                        std::vector<bool> &visited,
-                                        std::vector<bool> &visited_copy,
-                                        std::vector<int> &id_stack) {
-  // any visited cell is connected to start
-  // because we saved visited cells after inital check
-  // so, if id does not have a neighbor pawn that is visited
-  // it is not connected to start
-  // so we return, and do not mark it as visited
-  // so it can be visited again in the future
-
-  bool has_visited_neighbor = is_id_start_side(id, player);
-
-  int adj[6];
-  int n_count = neighbors(id, adj);
-  for (int i = 0; i < n_count; i++) {
-    int n = adj[i];
-    has_visited_neighbor =
-        has_visited_neighbor || (visited[n] && cells[n] == player);
-
-    if (has_visited_neighbor) {
+// 0-1 bfs from the player's edge, one layer per empty cell taken:
+// layers[d] is every cell reached taking at most d empty cells, own stones
+// are free and opponent stones blocked
+// returns the first d that reaches the other edge, limit + 1 if none does
+int Board::distance_layers(const Player player, const bool from_dest,
+                           const int limit, Bitboard *layers) {
+  const Bitboard own = player_bits(player);
+  const Bitboard empty = masks.all & ~(red_bits | blue_bits);
+  Bitboard start = player == RED ? masks.red_start : masks.blue_start;
+  Bitboard dest = player == RED ? masks.red_dest : masks.blue_dest;
+  if (from_dest) {
+    Bitboard tmp = start;
+    start = dest;
+    dest = tmp;
+  }
+
+  int found = limit + 1;
+  Bitboard reach = start & own;
+  for (int d = 0; d <= limit; d++) {
+    while (true) {
+      Bitboard next = reach | (bb_expand(reach, masks) & own);
+      if (next == reach) {
+        break;
+      }
+      reach = next;
+    }
+    if (layers != nullptr) {
+      layers[d] = reach;
+    }
+    if ((reach & dest) && found > limit) {
+      found = d;
+      if (layers == nullptr) {
+        return found;
+      }
+    }
+
+    Bitboard next = reach | ((bb_expand(reach, masks) | start) & empty);
+    if (next == reach) {
+      // nothing left to take, the remaining layers are all the same
+      for (int rest = d + 1; layers != nullptr && rest <= limit; rest++) {
+        layers[rest] = reach;
+      }
       break;
     }
+    reach = next;
   }
-  if (!has_visited_neighbor) {
-    return false;
+  return found;
+}
+
+int Board::stones_needed(const Player player, const int limit) {
+  return distance_layers(player, false, limit, nullptr);
+}
+
+// a cell taking d_start empty cells from one edge and d_dest from the other
+// (itself counted in both) is on a path of d_start + d_dest - 1 stones
+Bitboard Board::short_path_cells(const Player player, const int moves) {
+  const Bitboard empty = masks.all & ~(red_bits | blue_bits);
+  if (moves > MAX_CELLS) {
+    return empty;
   }
-  int len = size * size;
-  visited_copy.reserve(len);
-  for (int i = 0; i < size; i++) {
-    visited_copy[i] = visited[i];
+  Bitboard from_start[MAX_CELLS + 1];
+  Bitboard from_dest[MAX_CELLS + 1];
+  distance_layers(player, false, moves, from_start);
+  distance_layers(player, true, moves, from_dest);
+
+  Bitboard cells = 0;
+  for (int d = 1; d <= moves; d++) {
+    cells |= from_start[d] & from_dest[moves + 1 - d];
   }
+  return cells & empty;
+}
 
-  return is_player_connected_from_start(player, id, visited, id_stack);
+// every stone played from here on takes an empty cell; the opponent is
+// to reply after at most 2 * moves - 2 (player first) or
+// 2 * moves - 1 (opponent first) of them
+bool Board::can_run_out_of_replies(const int moves, const bool perfect_op,
+                                   const bool op_first) {
+  if (!perfect_op) {
+    return false;
+  }
+  int free = size * size - red_count - blue_count;
+  return free < 2 * moves - (op_first ? 1 : 2);
 }
 
 Player Board::curr_turn() {
@@ -331,37 +455,105 @@ Player Board::winner() {
   return NONE;
 }
 
+// the win is legal if the last stone could have completed it, that is if
+// some stone of the player lies on every path between their edges
+// one dfs over the stones and the two edges (tarjan's low links) finds
+// such a stone: a cut vertex between the start edge, the root, and the
+// destination edge
+// nodes are padded positions, each edge is the single position pad_edge
 bool Board::is_victory_legal(const Player player) {
   assert(player != NONE);
-  int &player_count = player == RED ? red_count : blue_count;
-  player_count--;
-
-  std::vector<bool> visited(size * size, false);
-
-  for (int row = 0; row < size; row++) {
-    for (int col = 0; col < size; col++) {
-      int id = row * size + col;
-      if (cells[id] != player) {
-        continue;
+  const Bitboard own = player_bits(player);
+  const int start = pad_edge(size, player, false);
+  const int dest = pad_edge(size, player, true);
+  const uint8_t start_value = border_start(player);
+  const uint8_t dest_value = border_dest(player);
+  // stones not yet walked to from each edge node
+  Bitboard edge_left[2] = {
+      own & (player == RED ? masks.red_start : masks.blue_start),
+      own & (player == RED ? masks.red_dest : masks.blue_dest)};
+
+  VisitedSet &seen = scratch.visited[0];
+  seen.clear();
+  int *stack = scratch.stacks[0];
+  int disc[PAD_CELLS];
+  int low[PAD_CELLS];
+  int parent[PAD_CELLS];
+  uint8_t next_dir[PAD_CELLS];
+
+  int stack_len = 0;
+  int time = 0;
+  seen.set(start);
+  disc[start] = low[start] = ++time;
+  parent[start] = -1;
+  stack[stack_len++] = start;
+
+  while (stack_len > 0) {
+    const int v = stack[stack_len - 1];
+    int w = -1;
+    if (v == start || v == dest) {
+      Bitboard &left = edge_left[v == dest];
+      if (left) {
+        w = pad_index(bb_first(left));
+        left &= left - 1;
       }
-      cells[id] = NONE;
-
-      visited.assign(visited.size(), false);
-      bool is_connected = is_player_connected_with_visited(player, visited);
-
-      cells[id] = player;
+    } else {
+      while (w < 0 && next_dir[v] < 6) {
+        const int pos = v + PAD_OFFSETS[next_dir[v]++];
+        const uint8_t value = padded[pos];
+        if (value == player) {
+          w = pos;
+        } else if (value == start_value) {
+          w = start;
+        } else if (value == dest_value) {
+          w = dest;
+        }
+      }
+    }
 
-      if (!is_connected) {
-        player_count++;
-        return true;
+    if (w < 0) {
+      // every edge of v is walked
+      stack_len--;
+      const int p = parent[v];
+      if (p >= 0 && low[v] < low[p]) {
+        low[p] = low[v];
       }
+    } else if (!seen.test(w)) {
+      seen.set(w);
+      disc[w] = low[w] = ++time;
+      parent[w] = v;
+      next_dir[w] = 0;
+      stack[stack_len++] = w;
+    } else if (disc[w] < low[v]) {
+      // the edge to the parent counts too, that does not change which
+      // stones are cut vertices
+      low[v] = disc[w];
     }
   }
-  player_count++;
+
+  if (!seen.test(dest)) {
+    return false;
+  }
+  // a stone on the tree path to dest cuts it off if nothing below it
+  // reaches back above it
+  int child = dest;
+  for (int v = parent[dest]; v != start; v = parent[v]) {
+    if (low[child] >= disc[v]) {
+      return true;
+    }
+    child = v;
+  }
   return false;
 }
 
 bool Board::is_board_possible() {
+  bool possible;
+  if (solutions != nullptr && solutions->lookup_possible(*this, possible)) {
+    if (USE_STATS) {
+      stats.solution_hits++;
+    }
+    return possible;
+  }
   if (!is_board_correct()) {
     return false;
   }
@@ -392,24 +584,14 @@ bool Board::is_board_possible() {
 
   return true;
 }
+// cells on the edge see a border value, so they always have a neighbor
 bool Board::has_neighbor(const int id) {
-  int row = id / size;
-  int col = id % size;
-  bool is_edge = row == 0 || col == 0 || row == size - 1 || col == size - 1;
-  if (is_edge) {
-    return true;
-  }
-
-  int neighbor_arr[6];
-  int n_count = neighbors(id, neighbor_arr);
-  for (int i = 0; i < n_count; i++) {
-    int n_id = neighbor_arr[i];
-
-    if (cells[n_id] != NONE) {
+  const int pos = pad_index(id);
+  for (int offset : PAD_OFFSETS) {
+    if (padded[pos + offset] != NONE) {
       return true;
     }
   }
-
   return false;
 }
 bool Board::sensible_move(const int id) { return has_neighbor(id); }
@@ -418,197 +600,51 @@ int &Board::curr_player_count() {
   return curr_turn() == RED ? red_count : blue_count;
 }
 
-bool Board::can_player_win_in_one_move_p_turn(std::vector<bool> &visited,
-                                              const Player player) {
-  std::vector<int> id_stack;
-
-  for (int id : sensible_moves) {
-    if (cells[id] != NONE) {
-      continue;
-    }
-
-    cells[id] = player;
-
-    std::vector<bool> visited_copy;
-
-    bool player_won = is_player_connected_partial(player, id, visited,
-                                                  visited_copy, id_stack);
-
-    cells[id] = NONE;
-
-    if (player_won) {
-      return true;
-    }
+void Board::create_uf() {
+  if (created_uf) {
+    return;
   }
-  return false;
-}
-bool Board::can_player_win_in_one_move_op_turn(std::vector<bool> &visited,
-                                               const Player player,
-                                               bool perfect_op) {
-  std::vector<int> id_stack;
+  created_uf = true;
 
-  Player opponent = opposite_player(player);
-  std::vector<int> &op_move_positions =
-      perfect_op ? sensible_moves : naive_op_moves;
+  uf.init(PAD_CELLS);
+  for (int i = 1; i < size; i++) {
+    uf.unite(pad_pos(i, -1), pad_pos(0, -1));
+    uf.unite(pad_pos(i, size), pad_pos(0, size));
+    uf.unite(pad_pos(-1, i), pad_pos(-1, 0));
+    uf.unite(pad_pos(size, i), pad_pos(size, 0));
+  }
 
-  for (int id : op_move_positions) {
+  int len = size * size;
+  for (int id = 0; id < len; id++) {
     if (cells[id] != NONE) {
-      continue;
+      unite_stone(id, cells[id]);
     }
-    cells[id] = opponent;
-
-    std::vector<bool> visited_copy;
-
-    bool opponent_won = is_player_connected_partial(opponent, id, visited,
-                                                    visited_copy, id_stack);
-
-    if (!opponent_won && visited_copy.empty()) {
-      visited_copy = visited;
-    }
-    bool player_wins = !opponent_won &&
-                       can_player_win_in_one_move_p_turn(visited_copy, player);
-
-    cells[id] = NONE;
-
-    if (perfect_op && !player_wins) {
-      return false;
-    }
-    if (!perfect_op && player_wins) {
-      return true;
-    }
-  }
-  if (perfect_op) {
-    return true;
   }
-  return false;
 }
 
-bool Board::can_player_win_in_one_move(const Player player, bool perfect_op) {
-  assert(player != NONE);
-  Player turn = curr_turn();
-
-  bool all_occupied = red_count + blue_count == size * size;
-  Player opponent = opposite_player(player);
-
-  bool player_won = is_player_connected(player);
-  bool op_won = is_player_connected(opponent);
-
-  if (all_occupied || player_won || op_won) {
-    return false;
-  }
-
-  create_moves();
-
-  int &curr_turn_count = curr_player_count();
-  curr_turn_count++;
-  bool can_win;
-  if (turn == player) {
-    can_win = can_player_win_in_one_move_p_turn(base_visited, player);
-  } else {
-    can_win =
-        can_player_win_in_one_move_op_turn(base_visited, player, perfect_op);
-  }
-  curr_turn_count--;
-
-  return can_win;
+int Board::uf_edge(const Player player, const bool dest) {
+  return pad_edge(size, player, dest);
 }
-bool Board::can_player_win_in_two_moves_p_turn(std::vector<bool> &visited,
-                                               const Player player,
-                                               bool perfect_op) {
-  std::vector<int> id_stack;
-
-  // for (int id : sensible_moves) {
-  for (int id : player_moves) {
-    if (cells[id] != NONE) {
-      continue;
-    }
-    cells[id] = player;
-
-    std::vector<bool> visited_copy;
 
-    bool won = is_player_connected_partial(player, id, visited, visited_copy,
-                                           id_stack);
-    if (!won && visited_copy.empty())
-      visited_copy = visited;
-
-    bool can_win = !won && can_player_win_in_one_move_op_turn(
-                               visited_copy, player, perfect_op);
-
-    cells[id] = NONE;
-
-    if (can_win) {
-      return true;
-    }
-  }
-  return false;
+void Board::unite_stone(const int id, const Player player) {
+  kernels->unite_stone(*this, id, player);
 }
-bool Board::can_player_win_in_two_moves_op_turn(std::vector<bool> &visited,
-                                                const Player player,
-                                                bool perfect_op) {
-  Player opponent = opposite_player(player);
-  std::vector<int> id_stack;
-  std::vector<int> &op_move_positions =
-      perfect_op ? sensible_moves : naive_op_moves;
-
-  for (int id : op_move_positions) {
-    if (cells[id] != NONE) {
-      continue;
-    }
-    cells[id] = opponent;
-
-    std::vector<bool> visited_copy;
-
-    bool opponent_won = is_player_connected_partial(opponent, id, visited,
-                                                    visited_copy, id_stack);
-    if (!opponent_won && visited_copy.empty())
-      visited_copy = visited;
 
-    bool player_can_win =
-        !opponent_won &&
-        can_player_win_in_two_moves_p_turn(visited_copy, player, perfect_op);
-
-    cells[id] = NONE;
-
-    if (perfect_op && !player_can_win) {
-      return false;
-    }
-    if (!perfect_op && player_can_win) {
-      return true;
-    }
-  }
-  if (perfect_op) {
-    return true;
-  }
-  return false;
+bool Board::place_stone(const int id, const Player player) {
+  set_cell(id, player);
+  unite_stone(id, player);
+  return uf.same(uf_edge(player, false), uf_edge(player, true));
 }
-bool Board::can_player_win_in_two_moves(const Player player, bool perfect_op) {
-  assert(player != NONE);
-  Player turn = curr_turn();
-
-  bool all_occupied = red_count + blue_count == size * size;
-  Player opponent = opposite_player(player);
-
-  bool player_won = is_player_connected(player);
-  bool op_won = is_player_connected(opponent);
-
-  if (all_occupied || player_won || op_won) {
-    return false;
-  }
-
-  create_moves();
 
-  int &curr_turn_count = curr_player_count();
-  curr_turn_count++;
-  bool can_win;
+void Board::remove_stone(const int id, const int uf_mark) {
+  uf.undo(uf_mark);
+  set_cell(id, NONE);
+}
 
-  if (turn == player) {
-    can_win =
-        can_player_win_in_two_moves_p_turn(base_visited, player, perfect_op);
-  } else {
-    can_win =
-        can_player_win_in_two_moves_op_turn(base_visited, player, perfect_op);
+Bitboard Board::winning_cells(const Player player) {
+  if (USE_STATS) {
+    stats.winning_move_scans++;
   }
-  curr_turn_count--;
-
-  return can_win;
+  return kernels->winning_cells(player_bits(player),
+                                masks.all & ~(red_bits | blue_bits), player);
 }
@@ -1,9 +1,33 @@
 #pragma once
 
+#include "bitboard.h"
+#include "cache.h"
+#include "hsearch.h"
+#include "io.h"
+#include "ordering.h"
+#include "scratch.h"
+#include "stats.h"
+#include "transposition.h"
+#include "union_find.h"
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #define FIRST RED
 #define SECOND BLUE
-#define MAX_SIZE 11
+// MAX_SIZE and MAX_CELLS are in bitboard.h
+// a query line, or the widest line of the largest board
+#define MAX_LINE_LEN (6 * MAX_SIZE + 4)
+
+struct SolutionTable;
+
+// connectivity through bitboards instead of dfs over cells
+#define USE_BITBOARD true
+
+// virtual connections prove CAN_* wins and prune perfect opponent replies
+#define USE_HSEARCH true
+
+// the searches try killer, history and threat moves first
+#define USE_ORDERING true
 
 enum Player {
   NONE,
@@ -11,6 +35,63 @@ enum Player {
   BLUE,
 };
 
+Player opposite_player(Player player);
+
+// cells are mirrored into a board with a one cell border, every padded row
+// is PAD_STRIDE wide whatever the size, so the six neighbors of a cell are
+// always the same offsets and never need a bounds check
+#define PAD_STRIDE (MAX_SIZE + 2)
+#define PAD_CELLS (PAD_STRIDE * PAD_STRIDE)
+
+// values of the border cells, next to NONE / RED / BLUE of the cells
+enum Border {
+  BORDER_RED_START = 3,
+  BORDER_RED_DEST,
+  BORDER_BLUE_START,
+  BORDER_BLUE_DEST,
+  // the four corners, no side of the board
+  BORDER_OUTSIDE,
+};
+
+// (row, col) steps to the six neighbors, in the order of Board::neighbors
+constexpr int HEX_DIRECTIONS[6][2] = {{0, 1},  {0, -1}, {1, 0},
+                                      {-1, 0}, {1, 1},  {-1, -1}};
+constexpr int PAD_OFFSETS[6] = {1, -1, PAD_STRIDE, -PAD_STRIDE,
+                                PAD_STRIDE + 1, -PAD_STRIDE - 1};
+
+// row and col may be -1 or size, for the border
+constexpr int pad_pos(const int row, const int col) {
+  return (row + 1) * PAD_STRIDE + col + 1;
+}
+
+inline uint8_t border_start(const Player player) {
+  return player == RED ? BORDER_RED_START : BORDER_BLUE_START;
+}
+inline uint8_t border_dest(const Player player) {
+  return player == RED ? BORDER_RED_DEST : BORDER_BLUE_DEST;
+}
+
+// one border cell of the side, create_uf unites it with the rest of the side
+constexpr int pad_edge(const int size, const Player player, const bool dest) {
+  if (player == RED) {
+    return dest ? pad_pos(0, size) : pad_pos(0, -1);
+  }
+  return dest ? pad_pos(size, 0) : pad_pos(-1, 0);
+}
+
+// holds cell ids or padded positions
+typedef EpochVisited<PAD_CELLS> VisitedSet;
+
+// random keys, xor of the keys of all stones is the position hash
+uint64_t zobrist_cell(const int id, const Player player);
+// tells apart searches of the same position for different queries
+uint64_t zobrist_query(const Player player, const int moves,
+                       const bool perfect_op);
+
+struct ParallelSearch;
+struct KernelTable;
+struct PositionCounts;
+
 // SIZE * size hexagonal board
 //
 // example 3x3 board:
@@ -22,30 +103,84 @@ enum Player {
 //
 struct Board {
   int size;
+  // new for every parsed board, tells copies whether their caches are stale
+  int board_id;
   std::vector<Player> cells;
+  // cells at pad_pos(row, col) plus the border, kept in sync by set_cell
+  uint8_t padded[PAD_CELLS];
   int red_count;
   int blue_count;
 
+  // kept in sync with cells, see set_cell
+  Bitboard red_bits, blue_bits;
+  uint64_t hash;
+  BoardMasks masks;
+  // specialized for size, set once the board is parsed
+  const KernelTable *kernels;
+
   bool red_connected, blue_connected;
-  bool created_visited, created_moves;
+  bool created_visited, created_moves, created_uf;
+  bool created_canonical_key;
+  uint64_t canonical;
+  bool canonical_swapped;
 
-  std::vector<bool> base_visited;
   std::vector<int> sensible_moves;
   std::vector<int> naive_op_moves;
   std::vector<int> player_moves;
+  // cells of sensible_moves
+  Bitboard sensible_bits;
+
+  // all the walks over cells use these, nothing is allocated per walk
+  Scratch<PAD_CELLS> scratch;
+
+  // stones of each color and the four edges, used by the searches
+  // nodes are padded positions, the border cells of each side start out
+  // as one set
+  UnionFind uf;
+
+  // results of every CAN_* query on this board, cleared in reset
+  TranspositionTable tt;
+
+  // virtual connections of the last vc_compute
+  VirtualConnections vc;
+
+  // cutoffs of the searches, cleared with tt
+  MoveOrdering ordering;
+
+  // set when CAN_* queries should be split across threads
+  ParallelSearch *parallel;
+  // set when CAN_* answers are kept on disk
+  ResultCache *cache;
+  // set when the answers of the small sizes are precomputed
+  const SolutionTable *solutions;
+  // set on worker copies, the search gives up once it is raised
+  const std::atomic<bool> *abort_flag;
+
+  // only counted with USE_STATS
+  Stats stats;
 
   void create_visited();
   void create_moves();
+  void create_uf();
 
-  // we just assume every board is of max size
-  // after, parsing the input, we will shrink it
+  // room for the largest board, parsing sets the actual size
   Board();
 
   // deep copy
   Board(const Board &other);
+  // copies the position and everything derived from it, but not the
+  // transposition table or the threading setup
+  void copy_position(const Board &other);
   void resize(int new_size);
   void reset();
-  void parse_from_stdin();
+  void parse(InputBuffer &in);
+  // size and cells in row-major order, 2 bits per cell, see binary.h
+  void unpack(const int new_size, const uint8_t *packed);
+  // everything kept alongside cells, after size and cells are set
+  void update_from_cells();
+
+  void set_cell(const int id, const Player player);
+  Bitboard &player_bits(const Player player);
 
   int player_count(const Player player);
   Player curr_turn();
@@ -56,42 +191,79 @@ struct Board {
 
   bool is_pos_valid(const int row, const int col);
   int neighbors(const int id, int (&arr_out)[6]);
+  int pad_index(const int id);
 
-  int is_id_dest_side(const int id, const Player player);
-  int is_id_start_side(const int id, const Player player);
-
-  bool is_player_connected_from_start(const Player player, const int id,
-                                      std::vector<bool> &visited,
-                                      std::vector<int> &id_stack);
+  bool is_player_connected_from_start(const Player player, const int pos,
+                                      VisitedSet &visited, int *pos_stack);
   bool is_player_connected(const Player player);
+  bool is_player_connected_bits(const Player player);
 
   bool is_player_connected_with_visited(const Player player,
-                                        std::vector<bool> &visited);
-
-  bool is_player_connected_partial(const Player player, const int id,
-                                   std::vector<bool> &visited,
-                                   std::vector<bool> &visited_copy,
-                                   std::vector<int> &id_stack);
+                                        VisitedSet &visited);
 
   bool is_victory_legal(const Player player);
 
   bool sensible_move(const int id);
   bool has_neighbor(const int id);
   int &curr_player_count();
-  bool can_player_win_in_one_move(const Player player, bool perfect_op);
+  int uf_edge(const Player player, const bool dest);
+  void unite_stone(const int id, const Player player);
+
+  // places the stone and returns whether player is now connected
+  // remove_stone(id, uf.mark() from before place_stone) takes it back
+  bool place_stone(const int id, const Player player);
+  void remove_stone(const int id, const int uf_mark);
+  // every empty cell that connects the player
+  Bitboard winning_cells(const Player player);
 
-  bool can_player_win_in_one_move_p_turn(std::vector<bool> &visited,
-                                         const Player player);
+  // the player makes `moves` moves, the opponent moves in between
+  // (and first, if it is their turn); the player has to win with the last
+  // one and nobody may win before that
+  // perfect opponent: every reply has to be refuted
+  // naive opponent: some sequence of replies lets the player win
+  bool can_player_win_in_n_moves(const Player player, const int moves,
+                                 bool perfect_op);
+  // the same, without the solution table or the result cache
+  bool solve_n_moves(const Player player, const int moves, bool perfect_op);
+  // hash of the position under the symmetries, the same for every position
+  // with the same answers (with the colors swapped if swapped is set)
+  uint64_t canonical_key(bool &swapped);
 
-  bool can_player_win_in_one_move_op_turn(std::vector<bool> &visited,
-                                          const Player player, bool perfect_op);
+  // stones the player still has to place to connect, limit + 1 if more
+  int stones_needed(const Player player, const int limit);
+  int distance_layers(const Player player, const bool from_dest,
+                      const int limit, Bitboard *layers);
+  // empty cells on some connection of at most `moves` stones
+  Bitboard short_path_cells(const Player player, const int moves);
+  // a perfect opponent that finds every cell taken lets the search pass,
+  // so distances only prove a NO when that can not happen
+  bool can_run_out_of_replies(const int moves, const bool perfect_op,
+                              const bool op_first);
+  bool vc_compute(const Player player, const int moves, const int op_moves);
+  // a sure win for the query, turn is the side to move
+  bool vc_proves_win(const Player player, const Player turn, const int moves);
+  // perfect opponent to move, player has `moves` moves after the reply
+  // true if every reply loses, otherwise replies is set to the cells the
+  // opponent has to play in (all of them if there is nothing to go by)
+  bool vc_must_play(const Player player, const int moves, Bitboard &replies);
 
-  bool can_player_win_in_two_moves_p_turn(std::vector<bool> &visited,
-                                          const Player player, bool perfect_op);
+  // a move for the player by monte-carlo tree search, -1 if there is
+  // none; stops after `playouts` playouts or `ms` milliseconds, whichever
+  // is set, and tells how many were played
+  int genmove(const Player player, const int playouts, const int ms,
+              int &played);
 
-  bool can_player_win_in_two_moves_op_turn(std::vector<bool> &visited,
-                                           const Player player,
-                                           bool perfect_op);
+  // every continuation `depth` moves deep from the side to move, see
+  // PositionCounts; split across threads when parallel is set
+  void count_positions(const int depth, PositionCounts &counts);
+  void count_positions_from(const Player turn, const int depth,
+                            PositionCounts &counts);
 
-  bool can_player_win_in_two_moves(const Player player, bool perfect_op);
+  bool aborted();
+  // the cells in the order to search them, see MoveOrdering::order
+  int order_moves(const int side, const int moves, const Bitboard cells,
+                  const Bitboard urgent, const Bitboard threats, int *out);
+  void cutoff(const int side, const int moves, const int id, const int tried);
+  bool search_p_turn(const Player player, const int moves, bool perfect_op);
+  bool search_op_turn(const Player player, const int moves, bool perfect_op);
 };
@@ -0,0 +1,201 @@
+#include "cache.h"
+#include "board.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int cache_query_bit(const bool red, const int moves, const bool perfect_op) {
+  if (moves < 1 || moves > CACHE_MAX_MOVES) {
+    return -1;
+  }
+  return ((moves - 1) * 2 + (perfect_op ? 1 : 0)) * 2 + (red ? 0 : 1);
+}
+
+ResultCache::ResultCache()
+    : fd(-1), map(nullptr), map_len(0), entries(nullptr), mask(0) {}
+
+ResultCache::~ResultCache() {
+  if (map != nullptr) {
+    munmap(map, map_len);
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
+static bool header_valid(const CacheHeader &header, const size_t file_len) {
+  if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION ||
+      header.entry_size != sizeof(CacheEntry)) {
+    return false;
+  }
+  uint64_t count = header.entry_count;
+  return count > 0 && (count & (count - 1)) == 0 &&
+         file_len == sizeof(CacheHeader) + count * sizeof(CacheEntry);
+}
+
+// the new file is complete before it shows up under path, so no one
+// maps it half written
+static bool create_file(const char *path, const int bits) {
+  std::string tmp = std::string(path) + ".tmp." + std::to_string(getpid());
+  int file = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (file < 0) {
+    return false;
+  }
+  uint64_t count = (uint64_t)1 << bits;
+  size_t len = sizeof(CacheHeader) + count * sizeof(CacheEntry);
+
+  CacheHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = CACHE_MAGIC;
+  header.version = CACHE_VERSION;
+  header.entry_size = sizeof(CacheEntry);
+  header.entry_count = count;
+
+  // the entries are zero, empty, without writing them
+  bool ok = ftruncate(file, len) == 0 &&
+            pwrite(file, &header, sizeof(header), 0) == sizeof(header);
+  close(file);
+  if (!ok || rename(tmp.c_str(), path) != 0) {
+    unlink(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool ResultCache::open(const char *path, const int bits) {
+  // once to create or replace the file, once more to map it
+  for (int attempt = 0; attempt < 2; attempt++) {
+    int file = ::open(path, O_RDWR);
+    if (file < 0) {
+      if (errno != ENOENT || !create_file(path, bits)) {
+        return false;
+      }
+      continue;
+    }
+
+    struct stat st;
+    CacheHeader header;
+    bool valid = fstat(file, &st) == 0 &&
+                 (size_t)st.st_size >= sizeof(header) &&
+                 pread(file, &header, sizeof(header), 0) == sizeof(header) &&
+                 header_valid(header, st.st_size);
+    if (!valid) {
+      close(file);
+      fprintf(stderr, "result cache %s is stale, starting a new one\n", path);
+      if (!create_file(path, bits)) {
+        return false;
+      }
+      continue;
+    }
+
+    void *mem = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     file, 0);
+    if (mem == MAP_FAILED) {
+      close(file);
+      return false;
+    }
+    fd = file;
+    map = mem;
+    map_len = st.st_size;
+    entries = (CacheEntry *)((char *)mem + sizeof(CacheHeader));
+    mask = header.entry_count - 1;
+    return true;
+  }
+  return false;
+}
+
+// 0 is the key of an empty entry
+static uint64_t entry_key(const uint64_t key) { return key != 0 ? key : 1; }
+
+bool ResultCache::lookup(const uint64_t key, const int bit, bool &answer) {
+  const uint64_t stored = entry_key(key);
+  for (int i = 0; i < CACHE_PROBES; i++) {
+    CacheEntry &entry = entries[(stored + i) & mask];
+    uint64_t data = __atomic_load_n(&entry.data, __ATOMIC_RELAXED);
+    uint64_t check = __atomic_load_n(&entry.check, __ATOMIC_RELAXED);
+    if ((check ^ data) != stored) {
+      continue;
+    }
+    if (!((data >> bit) & 1)) {
+      return false;
+    }
+    answer = (data >> (32 + bit)) & 1;
+    return true;
+  }
+  return false;
+}
+
+void ResultCache::store(const uint64_t key, const int bit, const bool answer) {
+  const uint64_t stored = entry_key(key);
+  // the entry of the key, else the first empty one, else the home slot
+  CacheEntry *target = nullptr;
+  uint64_t data = 0;
+  for (int i = 0; i < CACHE_PROBES; i++) {
+    CacheEntry &entry = entries[(stored + i) & mask];
+    uint64_t entry_data = __atomic_load_n(&entry.data, __ATOMIC_RELAXED);
+    uint64_t check = __atomic_load_n(&entry.check, __ATOMIC_RELAXED);
+    if ((check ^ entry_data) == stored) {
+      target = &entry;
+      data = entry_data;
+      break;
+    }
+    if (target == nullptr && check == 0 && entry_data == 0) {
+      target = &entry;
+    }
+  }
+  if (target == nullptr) {
+    target = &entries[stored & mask];
+  }
+
+  data |= (uint64_t)1 << bit;
+  data &= ~((uint64_t)1 << (32 + bit));
+  data |= (uint64_t)answer << (32 + bit);
+  // between the two stores the entry does not check out for anyone
+  __atomic_store_n(&target->data, data, __ATOMIC_RELAXED);
+  __atomic_store_n(&target->check, stored ^ data, __ATOMIC_RELAXED);
+}
+
+// the answers stay the same under the 180 degree rotation, and under
+// swapping the colors of the transposed board when the side to move swaps
+// along with them, which is whenever the counts differ
+// the key is the smallest zobrist hash of these, swapped tells whether it
+// is one with the colors swapped
+uint64_t Board::canonical_key(bool &swapped) {
+  if (!created_canonical_key) {
+    created_canonical_key = true;
+
+    uint64_t keys[4] = {0, 0, 0, 0};
+    const int last = size - 1;
+    for (int row = 0; row < size; row++) {
+      for (int col = 0; col < size; col++) {
+        Player player = cells[row * size + col];
+        if (player == NONE) {
+          continue;
+        }
+        Player other = opposite_player(player);
+        keys[0] ^= zobrist_cell(row * size + col, player);
+        keys[1] ^= zobrist_cell((last - row) * size + last - col, player);
+        keys[2] ^= zobrist_cell(col * size + row, other);
+        keys[3] ^= zobrist_cell((last - col) * size + last - row, other);
+      }
+    }
+
+    int transforms = red_count != blue_count ? 4 : 2;
+    int best = 0;
+    for (int t = 1; t < transforms; t++) {
+      if (keys[t] < keys[best]) {
+        best = t;
+      }
+    }
+    // the same stones on another size are another position
+    canonical = keys[best] ^ ((uint64_t)size * 0x9e3779b97f4a7c15ull);
+    canonical_swapped = best >= 2;
+  }
+  swapped = canonical_swapped;
+  return canonical;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// optional on-disk cache of CAN_* answers, shared by every process that
+// opens the same file
+//
+// the file is a header and an open addressing table of CacheEntry, mapped
+// shared; entries are keyed by the position under the board symmetries
+// (see Board::cache_key) and hold one answer bit per query
+//
+// nothing is locked: an entry is two words written one after the other,
+// and check is key ^ data, so a reader that sees half of a write gets a
+// mismatch and treats it as a miss; two writers racing on an entry can
+// lose an answer, never corrupt one
+
+// bump whenever an answer could change: the rules of the search, the
+// zobrist keys, the symmetries or the layout below
+#define CACHE_VERSION 2
+// "HEXCACHE"
+#define CACHE_MAGIC 0x4548434143584548ull
+// log2 of the entries of a new file, 16 bytes each
+#define CACHE_DEFAULT_BITS 20
+// entries looked at from the home slot of a key
+#define CACHE_PROBES 8
+// CAN_* queries with more moves are not cached
+#define CACHE_MAX_MOVES 8
+
+struct CacheHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t entry_size;
+  uint64_t entry_count;
+  uint8_t reserved[40];
+};
+
+struct CacheEntry {
+  uint64_t check;
+  // low half: which answers are known, high half: the answers
+  uint64_t data;
+};
+
+// bit of a query in CacheEntry::data, -1 if it is not cached
+// red is the player of the canonical position
+int cache_query_bit(const bool red, const int moves, const bool perfect_op);
+
+struct ResultCache {
+  int fd;
+  void *map;
+  size_t map_len;
+  CacheEntry *entries;
+  uint64_t mask;
+
+  ResultCache();
+  ~ResultCache();
+
+  // maps path, creating it with 2^bits entries if it does not exist
+  // a file of another version is replaced by a new one, processes that
+  // still map the old file keep using it
+  bool open(const char *path, const int bits);
+
+  bool lookup(const uint64_t key, const int bit, bool &answer);
+  void store(const uint64_t key, const int bit, const bool answer);
+};
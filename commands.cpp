@@ -0,0 +1,261 @@
+#include "commands.h"
+#include "binary.h"
+#include "perft.h"
+#include "planner.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#define DEBUG false
+
+void print_bool(bool val, OutputBuffer &out) {
+  if (val)
+    out.write("YES");
+  else
+    out.write("NO");
+}
+
+bool string_startswith(const char *str, const char *prefix) {
+  return strncmp(str, prefix, strlen(prefix)) == 0;
+}
+
+bool parse_can_query(const char *cmd, Player &player, int &moves,
+                     bool &perfect_op) {
+  char player_str[MAX_LINE_LEN];
+  char moves_str[MAX_LINE_LEN];
+  char opponent_str[MAX_LINE_LEN];
+
+  // CAN_<P>_WIN_IN_<N>_MOVE(S)_WITH_<O>_OPPONENT
+  bool matched = sscanf(cmd, "CAN_%[^_]_WIN_IN_%d_%[^_]_WITH_%[^_]_OPPONENT",
+                        player_str, &moves, moves_str, opponent_str) == 4;
+  if (!matched || moves < 1 ||
+      strcmp(moves_str, moves == 1 ? "MOVE" : "MOVES") != 0) {
+    std::cerr << "Invalid command: " << cmd << "\n";
+    return false;
+  }
+  if (strcmp(player_str, "RED") == 0) {
+    player = RED;
+  } else if (strcmp(player_str, "BLUE") == 0) {
+    player = BLUE;
+  } else {
+    std::cerr << "Invalid player: " << player_str << "\n";
+    return false;
+  }
+
+  perfect_op = strcmp(opponent_str, "PERFECT") == 0;
+  return true;
+}
+
+bool parse_genmove(const char *cmd, Player &player, int &amount,
+                   bool &timed) {
+  char player_str[MAX_LINE_LEN];
+  int end = 0;
+
+  // the unit has to follow the number, GENMOVE <P> <N> MS is no command
+  bool matched = sscanf(cmd, "GENMOVE %s %d%n", player_str, &amount, &end) == 2;
+  if (!matched || amount < 1 ||
+      (cmd[end] != '\0' && strcmp(cmd + end, "MS") != 0)) {
+    std::cerr << "Invalid command: " << cmd << "\n";
+    return false;
+  }
+  if (strcmp(player_str, "RED") == 0) {
+    player = RED;
+  } else if (strcmp(player_str, "BLUE") == 0) {
+    player = BLUE;
+  } else {
+    std::cerr << "Invalid player: " << player_str << "\n";
+    return false;
+  }
+
+  timed = cmd[end] != '\0';
+  return true;
+}
+
+bool parse_count_positions(const char *cmd, int &depth) {
+  if (sscanf(cmd, "COUNT_POSITIONS %d", &depth) != 1 || depth < 0) {
+    std::cerr << "Invalid command: " << cmd << "\n";
+    return false;
+  }
+  return true;
+}
+
+static void answer(Board &board, const char *cmd, OutputBuffer &out) {
+  if (DEBUG) {
+    out.write("c: ");
+    out.write(cmd);
+    out.write(": ");
+  }
+
+  if (strcmp(cmd, "BOARD_SIZE") == 0) {
+    out.write_int(board.size);
+  } else if (strcmp(cmd, "PAWNS_NUMBER") == 0) {
+    out.write_int(board.red_count + board.blue_count);
+  } else if (strcmp(cmd, "IS_BOARD_CORRECT") == 0) {
+    print_bool(board.is_board_correct(), out);
+  } else if (strcmp(cmd, "IS_GAME_OVER") == 0) {
+    Player winner = board.winner();
+    switch (winner) {
+    case NONE:
+      out.write("NO");
+      break;
+    case RED:
+      out.write("YES RED");
+      break;
+    case BLUE:
+      out.write("YES BLUE");
+      break;
+    }
+  } else if (strcmp(cmd, "IS_BOARD_POSSIBLE") == 0) {
+    print_bool(board.is_board_possible(), out);
+  } else if (string_startswith(cmd, "WINNING_MOVES_")) {
+    // WINNING_MOVES_<P>: ids of the cells that win right away, NONE if
+    // there are none or the game is already over
+    const char *player_str = cmd + strlen("WINNING_MOVES_");
+    Player player;
+    if (strcmp(player_str, "RED") == 0) {
+      player = RED;
+    } else if (strcmp(player_str, "BLUE") == 0) {
+      player = BLUE;
+    } else {
+      std::cerr << "Invalid player: " << player_str << "\n";
+      return;
+    }
+
+    Bitboard wins = board.winner() == NONE ? board.winning_cells(player) : 0;
+    if (wins == 0) {
+      out.write("NONE");
+    }
+    for (bool first = true; wins; wins &= wins - 1, first = false) {
+      if (!first) {
+        out.write(" ", 1);
+      }
+      out.write_int(bb_first(wins));
+    }
+  } else if (string_startswith(cmd, "GENMOVE ")) {
+    // GENMOVE <P> <N>: a move for the player after N playouts, or N
+    // milliseconds with GENMOVE <P> <N>MS; NONE if there is no move
+    Player player;
+    int amount;
+    bool timed;
+    if (!parse_genmove(cmd, player, amount, timed)) {
+      return;
+    }
+
+    int played;
+    int move = board.genmove(player, timed ? 0 : amount, timed ? amount : 0,
+                             played);
+    if (move < 0) {
+      out.write("NONE");
+    } else {
+      out.write_int(move);
+    }
+  } else if (string_startswith(cmd, "COUNT_POSITIONS ")) {
+    // COUNT_POSITIONS <depth>: leaves, red wins, blue wins, pruned moves
+    // and the checksum in hex, see PositionCounts
+    int depth;
+    if (!parse_count_positions(cmd, depth)) {
+      return;
+    }
+    PositionCounts counts;
+    board.count_positions(depth, counts);
+    // four 64-bit counts and the checksum
+    char line[128];
+    int len = snprintf(line, sizeof(line), "%llu %llu %llu %llu %016llx",
+                       (unsigned long long)counts.leaves,
+                       (unsigned long long)counts.red_wins,
+                       (unsigned long long)counts.blue_wins,
+                       (unsigned long long)counts.pruned,
+                       (unsigned long long)counts.checksum);
+    out.write(line, len);
+  } else if (string_startswith(cmd, "CAN_")) {
+    Player player;
+    int moves;
+    bool perfect_op;
+    if (!parse_can_query(cmd, player, moves, perfect_op)) {
+      return;
+    }
+    print_bool(board.can_player_win_in_n_moves(player, moves, perfect_op),
+               out);
+  }
+  out.write("\n", 1);
+}
+
+void command(Board &board, const char *cmd, OutputBuffer &out) {
+  if (cmd[0] == '\0') {
+    return;
+  }
+  if (!USE_STATS) {
+    answer(board, cmd, out);
+    return;
+  }
+  StatsProbe probe;
+  probe.start();
+  answer(board, cmd, out);
+  probe.stop(board.stats, cmd);
+}
+void run_once(Board &board, InputBuffer &in, OutputBuffer &out) {
+  board.parse(in);
+
+  QueryPlan plan;
+  const char *line;
+  size_t len;
+  while (in.next_line(line, len)) {
+    if (len > 0 && (line[0] == '-' || line[0] == ' ')) {
+      // first line of the next board
+      break;
+    }
+    if (len >= MAX_LINE_LEN) {
+      std::cerr << "Invalid command: line too long\n";
+      continue;
+    }
+    if (USE_PLANNER) {
+      if (plan.full()) {
+        plan.run(board, out);
+      }
+      plan.add(line, len);
+      continue;
+    }
+
+    // commands are short, copy them to get the '\0' sscanf wants
+    char buffer[MAX_LINE_LEN];
+    memcpy(buffer, line, len);
+    buffer[len] = '\0';
+    command(board, buffer, out);
+  }
+  if (USE_PLANNER) {
+    plan.run(board, out);
+  }
+
+  if (USE_STATS) {
+    stats_board_done(board.stats, board.board_id);
+  }
+}
+
+bool run_binary_once(Board &board, InputBuffer &in, OutputBuffer &out) {
+  if (!binary_read_board(in, board)) {
+    return false;
+  }
+
+  QueryPlan plan;
+  BinaryQuery query;
+  char line[MAX_LINE_LEN];
+  while (binary_read_query(in, query)) {
+    binary_query_text(query, line);
+    if (USE_PLANNER) {
+      if (plan.full()) {
+        plan.run(board, out);
+      }
+      plan.add(line, strlen(line));
+    } else {
+      command(board, line, out);
+    }
+  }
+  if (USE_PLANNER) {
+    plan.run(board, out);
+  }
+
+  if (USE_STATS) {
+    stats_board_done(board.stats, board.board_id);
+  }
+  return true;
+}
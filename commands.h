@@ -0,0 +1,25 @@
+#pragma once
+
+#include "board.h"
+#include "io.h"
+
+void print_bool(bool val, OutputBuffer &out);
+bool string_startswith(const char *str, const char *prefix);
+// CAN_<P>_WIN_IN_<N>_MOVE(S)_WITH_<O>_OPPONENT, MOVE exactly when N is 1;
+// complains on stderr and returns false if cmd is not one
+bool parse_can_query(const char *cmd, Player &player, int &moves,
+                     bool &perfect_op);
+// GENMOVE <P> <N> and GENMOVE <P> <N>MS, timed for the latter
+bool parse_genmove(const char *cmd, Player &player, int &amount, bool &timed);
+// COUNT_POSITIONS <depth>
+bool parse_count_positions(const char *cmd, int &depth);
+
+// answers one query line about board, writes the answer line to out
+void command(Board &board, const char *cmd, OutputBuffer &out);
+
+// parses one board from in and answers the queries that follow it,
+// up to and including the first line of the next board
+// assumes first line "---" is consumed
+void run_once(Board &board, InputBuffer &in, OutputBuffer &out);
+// the same for binary input, see binary.h, false at the end of the input
+bool run_binary_once(Board &board, InputBuffer &in, OutputBuffer &out);
@@ -0,0 +1,326 @@
+#include "hsearch.h"
+#include "board.h"
+#include <algorithm>
+
+VirtualConnections::VirtualConnections()
+    : pair_full(VC_NODES * VC_NODES), pair_semi(VC_NODES * VC_NODES),
+      pair_stamp(VC_NODES * VC_NODES, 0), epoch(0), budget(0) {
+  // never grown past this, so computing allocates nothing
+  full.reserve(VC_MAX_FULL);
+  semi.reserve(VC_MAX_SEMI);
+}
+
+int VirtualConnections::pair_index(const int a, const int b) {
+  int index = a * VC_NODES + b;
+  if (pair_stamp[index] != epoch) {
+    pair_stamp[index] = epoch;
+    pair_full[index] = -1;
+    pair_semi[index] = -1;
+  }
+  return index;
+}
+
+void VirtualConnections::add_full(int a, int b, const Bitboard carrier,
+                                  const int stones) {
+  if (a == b || stones > budget) {
+    return;
+  }
+  if (a > b) {
+    int tmp = a;
+    a = b;
+    b = tmp;
+  }
+  int pair = pair_index(a, b);
+
+  int count = 0;
+  for (int i = pair_full[pair]; i >= 0; i = full[i].next_in_pair) {
+    // as good on a subset of the cells
+    if ((full[i].carrier & ~carrier) == 0 && full[i].stones <= stones) {
+      return;
+    }
+    count++;
+  }
+  if (count == VC_FULL_PER_PAIR || full.size() == full.capacity()) {
+    return;
+  }
+
+  VirtualConnection vc;
+  vc.carrier = carrier;
+  vc.a = a;
+  vc.b = b;
+  vc.stones = stones;
+  vc.key = -1;
+  vc.next_in_pair = pair_full[pair];
+  vc.next_of_a = node_full[a];
+  vc.next_of_b = node_full[b];
+
+  int id = full.size();
+  full.push_back(vc);
+  pair_full[pair] = id;
+  node_full[a] = id;
+  node_full[b] = id;
+}
+
+void VirtualConnections::add_semi(int a, int b, const Bitboard carrier,
+                                  const int key, const int stones) {
+  if (a == b || stones > budget) {
+    return;
+  }
+  if (a > b) {
+    int tmp = a;
+    a = b;
+    b = tmp;
+  }
+  int pair = pair_index(a, b);
+
+  for (int i = pair_full[pair]; i >= 0; i = full[i].next_in_pair) {
+    if ((full[i].carrier & ~carrier) == 0 && full[i].stones <= stones) {
+      return;
+    }
+  }
+  int count = 0;
+  for (int i = pair_semi[pair]; i >= 0; i = semi[i].next_in_pair) {
+    if ((semi[i].carrier & ~carrier) == 0 && semi[i].stones <= stones) {
+      return;
+    }
+    count++;
+  }
+  if (count == VC_SEMI_PER_PAIR || semi.size() == semi.capacity()) {
+    return;
+  }
+
+  VirtualConnection vc;
+  vc.carrier = carrier;
+  vc.a = a;
+  vc.b = b;
+  vc.stones = stones;
+  vc.key = key;
+  vc.next_in_pair = pair_semi[pair];
+  vc.next_of_a = -1;
+  vc.next_of_b = -1;
+  pair_semi[pair] = semi.size();
+  semi.push_back(vc);
+
+  // or-rule, greedily: keep adding semi connections that shrink the
+  // common part of the carriers until nothing is left of it
+  // an intrusion then misses at least one of them, whose key the player
+  // takes, so the result needs as many stones as the worst of them
+  Bitboard common = carrier;
+  Bitboard all = carrier;
+  int most_stones = stones;
+  for (int i = vc.next_in_pair; i >= 0; i = semi[i].next_in_pair) {
+    Bitboard next = common & semi[i].carrier;
+    if (next == common) {
+      continue;
+    }
+    common = next;
+    all |= semi[i].carrier;
+    if (semi[i].stones > most_stones) {
+      most_stones = semi[i].stones;
+    }
+    if (common == 0) {
+      add_full(a, b, all, most_stones);
+      return;
+    }
+  }
+}
+
+// and-rule for the full connection new_id through its endpoint mid,
+// with every full connection found before it
+void VirtualConnections::combine(const int new_id, const int mid) {
+  const VirtualConnection vc = full[new_id];
+  const int x = vc.a == mid ? vc.b : vc.a;
+  const bool mid_empty = bb_test(empty_nodes, mid);
+
+  int next;
+  for (int i = node_full[mid]; i >= 0; i = next) {
+    const VirtualConnection &other = full[i];
+    next = other.a == mid ? other.next_of_a : other.next_of_b;
+    if (i >= new_id) {
+      continue;
+    }
+    const int y = other.a == mid ? other.b : other.a;
+    if (y == x || (vc.carrier & other.carrier) != 0) {
+      continue;
+    }
+    // an empty endpoint may not be used by the other half
+    if (x < VC_CELL_NODES && bb_test(other.carrier, x)) {
+      continue;
+    }
+    if (y < VC_CELL_NODES && bb_test(vc.carrier, y)) {
+      continue;
+    }
+
+    Bitboard carrier = vc.carrier | other.carrier;
+    int stones = vc.stones + other.stones;
+    if (mid_empty) {
+      add_semi(x, y, carrier | bb_bit(mid), mid, stones + 1);
+    } else {
+      add_full(x, y, carrier, stones);
+    }
+  }
+}
+
+void VirtualConnections::compute(const Bitboard own, const Bitboard allowed,
+                                 const Bitboard start, const Bitboard dest,
+                                 const BoardMasks &masks,
+                                 const int new_budget) {
+  budget = new_budget;
+  epoch++;
+  if (epoch == 0) {
+    std::fill(pair_stamp.begin(), pair_stamp.end(), 0);
+    epoch = 1;
+  }
+  full.clear();
+  semi.clear();
+  for (int node = 0; node < VC_NODES; node++) {
+    node_full[node] = -1;
+  }
+
+  // empty cells are their own nodes, groups become one node
+  empty_nodes = allowed;
+  for (int id = 0; id < VC_CELL_NODES; id++) {
+    node_of[id] = bb_test(allowed, id) ? id : -1;
+  }
+  Bitboard rest = own;
+  while (rest) {
+    int first = bb_first(rest);
+    Bitboard group = bb_flood(bb_bit(first), own, masks);
+    rest &= ~group;
+    int node = (group & start) ? VC_START : (group & dest) ? VC_DEST : first;
+    for (Bitboard cells = group; cells; cells &= cells - 1) {
+      node_of[bb_first(cells)] = node;
+    }
+  }
+
+  // adjacent nodes are connected with an empty carrier
+  Bitboard usable = own | allowed;
+  for (Bitboard cells = usable; cells; cells &= cells - 1) {
+    int id = bb_first(cells);
+    int node = node_of[id];
+    if (bb_test(start, id)) {
+      add_full(node, VC_START, 0, 0);
+    }
+    if (bb_test(dest, id)) {
+      add_full(node, VC_DEST, 0, 0);
+    }
+    Bitboard adj = bb_expand(bb_bit(id), masks) & usable;
+    for (; adj; adj &= adj - 1) {
+      add_full(node, node_of[bb_first(adj)], 0, 0);
+    }
+  }
+
+  // every full connection is combined once with all the older ones,
+  // new ones are appended, so this runs until nothing new is found
+  for (size_t id = 0; id < full.size(); id++) {
+    int a = full[id].a;
+    int b = full[id].b;
+    // going through an edge does not connect anything
+    if (a < VC_CELL_NODES) {
+      combine(id, a);
+    }
+    if (b < VC_CELL_NODES) {
+      combine(id, b);
+    }
+  }
+}
+
+bool VirtualConnections::has_full(const int max_stones) {
+  int pair = pair_index(VC_START, VC_DEST);
+  for (int i = pair_full[pair]; i >= 0; i = full[i].next_in_pair) {
+    if (full[i].stones <= max_stones) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool VirtualConnections::has_semi(const int max_stones) {
+  bool found;
+  semi_intersection(max_stones, found);
+  return found;
+}
+
+Bitboard VirtualConnections::semi_intersection(const int max_stones,
+                                               bool &found) {
+  int pair = pair_index(VC_START, VC_DEST);
+  Bitboard common = ~(Bitboard)0;
+  found = false;
+  for (int i = pair_semi[pair]; i >= 0; i = semi[i].next_in_pair) {
+    if (semi[i].stones <= max_stones) {
+      common &= semi[i].carrier;
+      found = true;
+    }
+  }
+  return found ? common : 0;
+}
+
+// the player needs exactly `moves` stones and the opponent can not connect
+// with its `op_moves`, then a virtual connection of at most `moves` stones
+// is a win on exactly the last move: following it the player never connects
+// early, and never needs more stones
+bool Board::vc_compute(const Player player, const int moves,
+                       const int op_moves) {
+  if (stones_needed(player, moves) != moves) {
+    return false;
+  }
+  if (stones_needed(opposite_player(player), op_moves) <= op_moves) {
+    return false;
+  }
+
+  Bitboard allowed = masks.all & ~(red_bits | blue_bits);
+  const Bitboard start = player == RED ? masks.red_start : masks.blue_start;
+  const Bitboard dest = player == RED ? masks.red_dest : masks.blue_dest;
+  vc.compute(player_bits(player), allowed, start, dest, masks, moves);
+  return true;
+}
+
+bool Board::vc_proves_win(const Player player, const Player turn,
+                          const int moves) {
+  int op_moves = turn == player ? moves - 1 : moves;
+  // a naive opponent without a move to make fails the search
+  int empty = size * size - red_count - blue_count;
+  if (empty < moves + op_moves) {
+    return false;
+  }
+  if (!vc_compute(player, moves, op_moves)) {
+    return false;
+  }
+  return vc.has_full(moves) || (turn == player && vc.has_semi(moves));
+}
+
+bool Board::vc_must_play(const Player player, const int moves,
+                         Bitboard &replies) {
+  replies = masks.all;
+
+  if (moves == 1) {
+    // a one stone semi connection is a winning cell, carrying just itself
+    // the reply takes at most one of them and creates none
+    Bitboard wins = winning_cells(player);
+    if (bb_popcount(wins) >= 2) {
+      return true;
+    }
+    if (wins != 0) {
+      replies = wins;
+    }
+    return false;
+  }
+
+  // the opponent has its reply and moves - 1 more
+  if (!vc_compute(player, moves, moves)) {
+    return false;
+  }
+  if (vc.has_full(moves)) {
+    return true;
+  }
+  bool found;
+  Bitboard common = vc.semi_intersection(moves, found);
+  if (!found) {
+    return false;
+  }
+  if (common == 0) {
+    return true;
+  }
+  replies = common;
+  return false;
+}
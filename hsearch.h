@@ -0,0 +1,74 @@
+#pragma once
+
+#include "bitboard.h"
+#include <cstdint>
+#include <vector>
+
+// nodes of the H-search: cell ids, then the two edges of the player
+// a group of stones is the node of its lowest cell, or the edge it touches
+#define VC_CELL_NODES BB_BITS
+#define VC_START (VC_CELL_NODES)
+#define VC_DEST (VC_CELL_NODES + 1)
+#define VC_NODES (VC_CELL_NODES + 2)
+
+// connections kept per pair of nodes, and in total
+#define VC_FULL_PER_PAIR 8
+#define VC_SEMI_PER_PAIR 16
+#define VC_MAX_FULL (1 << 14)
+#define VC_MAX_SEMI (1 << 15)
+
+// a way to connect nodes a and b (a < b) using only the empty cells of the
+// carrier, whatever the opponent plays there; `stones` of them are enough
+// a semi connection needs the player to move first, at key
+struct VirtualConnection {
+  Bitboard carrier;
+  int16_t a, b;
+  int8_t stones;
+  int16_t key;
+  // next connection of the same pair
+  int32_t next_in_pair;
+  // next full connection touching a / b
+  int32_t next_of_a, next_of_b;
+};
+
+// H-search: full and semi virtual connections of one player built up from
+// adjacency with the and-rule (two connections in series) and the or-rule
+// (semi connections with disjoint carriers make a full one)
+// bridges and edge templates fall out of the or-rule, the edges are nodes
+// connections needing more than `budget` stones are not kept
+struct VirtualConnections {
+  std::vector<VirtualConnection> full;
+  std::vector<VirtualConnection> semi;
+
+  // heads of the per pair lists, valid when the stamp is the epoch
+  std::vector<int32_t> pair_full;
+  std::vector<int32_t> pair_semi;
+  std::vector<uint32_t> pair_stamp;
+  uint32_t epoch;
+  // full connections touching a node
+  int32_t node_full[VC_NODES];
+  // node of every cell, -1 for cells the player can not use
+  int16_t node_of[VC_CELL_NODES];
+  Bitboard empty_nodes;
+  int budget;
+
+  VirtualConnections();
+
+  // own stones and the empty cells the player may use, start and dest are
+  // the cells on the player's edges
+  void compute(const Bitboard own, const Bitboard allowed, const Bitboard start,
+               const Bitboard dest, const BoardMasks &masks,
+               const int new_budget);
+
+  // edge to edge connections with at most max_stones stones
+  bool has_full(const int max_stones);
+  bool has_semi(const int max_stones);
+  // cells in every such semi connection, found tells whether there is one
+  Bitboard semi_intersection(const int max_stones, bool &found);
+
+  int pair_index(const int a, const int b);
+  void add_full(int a, int b, const Bitboard carrier, const int stones);
+  void add_semi(int a, int b, const Bitboard carrier, const int key,
+                const int stones);
+  void combine(const int new_id, const int mid);
+};
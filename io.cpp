@@ -0,0 +1,225 @@
+#include "io.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+InputBuffer::InputBuffer()
+    : fd(-1), mapped(false), at_eof(true), data(nullptr), len(0), pos(0) {}
+
+InputBuffer::~InputBuffer() {
+  if (mapped) {
+    munmap((void *)data, len);
+  }
+}
+
+bool InputBuffer::open_file(const char *path) {
+  int file = open(path, O_RDONLY);
+  if (file < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(file, &st) != 0) {
+    close(file);
+    return false;
+  }
+  if (st.st_size == 0) {
+    close(file);
+    open_memory("", 0);
+    return true;
+  }
+
+  void *mem = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file);
+  if (mem == MAP_FAILED) {
+    return false;
+  }
+  madvise(mem, st.st_size, MADV_SEQUENTIAL);
+
+  mapped = true;
+  at_eof = true;
+  data = (const char *)mem;
+  len = st.st_size;
+  pos = 0;
+  return true;
+}
+
+void InputBuffer::open_fd(const int new_fd) {
+  fd = new_fd;
+  at_eof = false;
+  block.resize(INPUT_BLOCK_SIZE);
+  data = block.data();
+  len = 0;
+  pos = 0;
+}
+
+void InputBuffer::open_memory(const char *mem, const size_t mem_len) {
+  at_eof = true;
+  data = mem;
+  len = mem_len;
+  pos = 0;
+}
+
+void InputBuffer::refill() {
+  // keep the unfinished line, move it to the front
+  size_t left = len - pos;
+  memmove(block.data(), block.data() + pos, left);
+  len = left;
+  pos = 0;
+  if (len == block.size()) {
+    // a line longer than the whole block
+    block.resize(block.size() * 2);
+  }
+  data = block.data();
+
+  ssize_t got;
+  do {
+    got = read(fd, block.data() + len, block.size() - len);
+  } while (got < 0 && errno == EINTR);
+
+  if (got <= 0) {
+    at_eof = true;
+    return;
+  }
+  len += got;
+}
+
+bool InputBuffer::next_line(const char *&line, size_t &line_len) {
+  while (true) {
+    const char *start = data + pos;
+    const char *newline = (const char *)memchr(start, '\n', len - pos);
+    if (newline != nullptr) {
+      line = start;
+      line_len = newline - start;
+      pos += line_len + 1;
+      return true;
+    }
+    if (at_eof) {
+      if (pos == len) {
+        return false;
+      }
+      // last line without '\n'
+      line = start;
+      line_len = len - pos;
+      pos = len;
+      return true;
+    }
+    refill();
+  }
+}
+
+bool InputBuffer::at_end() {
+  while (pos == len && !at_eof) {
+    refill();
+  }
+  return pos == len;
+}
+
+bool InputBuffer::fill(const size_t count) {
+  while (len - pos < count && !at_eof) {
+    refill();
+  }
+  return len - pos >= count;
+}
+
+bool InputBuffer::next_bytes(const char *&bytes, const size_t count) {
+  if (!fill(count)) {
+    return false;
+  }
+  bytes = data + pos;
+  pos += count;
+  return true;
+}
+
+std::string render_board(const char *cells, const int size) {
+  std::string out;
+  const int pad = size > 0 ? 3 * (size - 1) : 0;
+  out.append(pad + 1, ' ');
+  out += "---\n";
+
+  // one line per diagonal, from the top corner (0, 0) down
+  for (int depth = 0; depth < 2 * size - 1; depth++) {
+    int row = depth < size ? depth : size - 1;
+    int col = depth < size ? 0 : depth - size + 1;
+    int indent = 3 * (depth < size ? size - 1 - depth : depth - size + 1);
+
+    if (depth == size - 1) {
+      out.append(indent, ' ');
+    } else {
+      out.append(indent - 2, ' ');
+      out += "--";
+    }
+    for (bool first = true; row >= 0 && col < size; row--, col++) {
+      if (!first) {
+        out += '-';
+      }
+      first = false;
+      out += "< ";
+      out += cells[row * size + col];
+      out += " >";
+    }
+    if (depth != size - 1) {
+      out += "--";
+    }
+    out += '\n';
+  }
+
+  out.append(pad + 1, ' ');
+  out += "---\n";
+  return out;
+}
+
+OutputBuffer::OutputBuffer(const int new_fd) : fd(new_fd) {
+  data.reserve(OUTPUT_FLUSH_SIZE * 2);
+}
+
+OutputBuffer::~OutputBuffer() { flush(); }
+
+void OutputBuffer::write(const char *str, const size_t str_len) {
+  data.insert(data.end(), str, str + str_len);
+  if (data.size() >= OUTPUT_FLUSH_SIZE) {
+    flush();
+  }
+}
+
+void OutputBuffer::write(const char *str) { write(str, strlen(str)); }
+
+void OutputBuffer::write_int(int val) {
+  char digits[16];
+  int count = 0;
+  bool negative = val < 0;
+  unsigned rest = negative ? -(unsigned)val : val;
+  do {
+    digits[count++] = '0' + rest % 10;
+    rest /= 10;
+  } while (rest > 0);
+  if (negative) {
+    digits[count++] = '-';
+  }
+
+  char out[16];
+  for (int i = 0; i < count; i++) {
+    out[i] = digits[count - 1 - i];
+  }
+  write(out, count);
+}
+
+void OutputBuffer::flush() {
+  if (fd < 0) {
+    return;
+  }
+  size_t done = 0;
+  while (done < data.size()) {
+    ssize_t wrote = ::write(fd, data.data() + done, data.size() - done);
+    if (wrote < 0 && errno == EINTR) {
+      continue;
+    }
+    if (wrote <= 0) {
+      break;
+    }
+    done += wrote;
+  }
+  data.clear();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// block size for reading from a file descriptor
+#define INPUT_BLOCK_SIZE (1 << 20)
+// OutputBuffer writes its data out once it grows past this
+#define OUTPUT_FLUSH_SIZE (1 << 16)
+
+// input split into lines without copying them
+// either a memory-mapped file, a block-wise read file descriptor,
+// or memory owned by someone else
+struct InputBuffer {
+  int fd;
+  bool mapped;
+  // no more data to read, everything left is in data[pos..len)
+  bool at_eof;
+
+  const char *data;
+  size_t len;
+  size_t pos;
+
+  // storage for the block-wise reads
+  std::vector<char> block;
+
+  InputBuffer();
+  ~InputBuffer();
+
+  // returns false if the file can not be opened or mapped
+  bool open_file(const char *path);
+  void open_fd(const int fd);
+  void open_memory(const char *mem, const size_t mem_len);
+
+  // line is valid until the next call, and is not '\0' terminated
+  bool next_line(const char *&line, size_t &line_len);
+  bool at_end();
+
+  // for binary input: makes count bytes readable at data + pos, false if
+  // the input ends before that
+  bool fill(const size_t count);
+  // count bytes, valid until the next call
+  bool next_bytes(const char *&bytes, const size_t count);
+
+  void refill();
+};
+
+// cells in row-major order as 'r', 'b' or ' ', written in the input format,
+// top "---" line included
+std::string render_board(const char *cells, const int size);
+
+// one reusable buffer for all the answers
+// fd -1 keeps everything in data, for the caller to take
+struct OutputBuffer {
+  int fd;
+  std::vector<char> data;
+
+  OutputBuffer(const int fd);
+  ~OutputBuffer();
+
+  void write(const char *str, const size_t str_len);
+  void write(const char *str);
+  void write_int(int val);
+  void flush();
+};
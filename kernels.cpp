@@ -0,0 +1,36 @@
+#include "kernels.h"
+#include <cassert>
+
+template <int N> static const KernelTable *table() {
+  static const KernelTable kernels = {
+      Kernels<N>::LAYOUT.to_padded,
+      Kernels<N>::neighbors,
+      Kernels<N>::connected,
+      Kernels<N>::unite_stone,
+      Kernels<N>::winning_cells,
+  };
+  return &kernels;
+}
+
+#if MAX_SIZE >= 19
+// ids past 255 on the largest board, a uint8_t table once cut them short
+static_assert(Kernels<19>::LAYOUT.neighbor_ids[300][0] == 301 &&
+                  Kernels<19>::LAYOUT.neighbor_ids[300][5] == 280,
+              "19x19 neighbor ids");
+#endif
+
+// the size is only known at run time, every size up to N is a table
+template <int N> static const KernelTable *table_up_to(const int size) {
+  if constexpr (N > 1) {
+    if (size < N) {
+      return table_up_to<N - 1>(size);
+    }
+  }
+  return table<N>();
+}
+
+const KernelTable *kernels_for_size(const int size) {
+  assert(size >= 0 && size <= MAX_SIZE);
+  // an empty board gets the table of size 1, it has no cells to look up
+  return table_up_to<MAX_SIZE>(size);
+}
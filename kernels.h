@@ -0,0 +1,151 @@
+#pragma once
+
+#include "board.h"
+#include <vector>
+
+// cell id -> padded position, and the neighbor lists of every cell
+template <int N> struct Layout {
+  static_assert(N * N <= INT16_MAX, "cell ids are int16_t");
+  int16_t to_padded[N * N];
+  uint8_t neighbor_count[N * N];
+  // in the order of HEX_DIRECTIONS, cells off the board left out
+  int16_t neighbor_ids[N * N][6];
+};
+
+// hot board functions, one instantiation per board size
+// with N known at compile time the row / column math, the edge tests and
+// the bitboard shifts become constants, and the loops can be unrolled
+template <int N> struct Kernels {
+  static constexpr int CELLS = N * N;
+
+  static constexpr Bitboard col_mask(const int col) {
+    Bitboard mask = 0;
+    for (int row = 0; row < N; row++) {
+      mask |= (Bitboard)1 << (row * N + col);
+    }
+    return mask;
+  }
+  static constexpr Bitboard row_mask(const int row) {
+    Bitboard mask = 0;
+    for (int col = 0; col < N; col++) {
+      mask |= (Bitboard)1 << (row * N + col);
+    }
+    return mask;
+  }
+  static constexpr Bitboard all_mask() {
+    Bitboard mask = 0;
+    for (int row = 0; row < N; row++) {
+      mask |= row_mask(row);
+    }
+    return mask;
+  }
+
+  static constexpr Bitboard ALL = all_mask();
+  static constexpr Bitboard NOT_FIRST_COL = ALL & ~col_mask(0);
+  static constexpr Bitboard NOT_LAST_COL = ALL & ~col_mask(N - 1);
+
+  static constexpr Layout<N> make_layout() {
+    Layout<N> layout{};
+    for (int id = 0; id < CELLS; id++) {
+      const int row = id / N;
+      const int col = id % N;
+      layout.to_padded[id] = pad_pos(row, col);
+
+      int count = 0;
+      for (int dir = 0; dir < 6; dir++) {
+        const int n_row = row + HEX_DIRECTIONS[dir][0];
+        const int n_col = col + HEX_DIRECTIONS[dir][1];
+        if (n_row >= 0 && n_row < N && n_col >= 0 && n_col < N) {
+          layout.neighbor_ids[id][count++] = n_row * N + n_col;
+        }
+      }
+      layout.neighbor_count[id] = count;
+    }
+    return layout;
+  }
+
+  static constexpr Layout<N> LAYOUT = make_layout();
+
+  static int neighbors(const int id, int (&arr_out)[6]) {
+    const int count = LAYOUT.neighbor_count[id];
+    for (int i = 0; i < count; i++) {
+      arr_out[i] = LAYOUT.neighbor_ids[id][i];
+    }
+    return count;
+  }
+
+  static Bitboard expand(const Bitboard bb) {
+    Bitboard out = ((bb << 1) & NOT_FIRST_COL) | ((bb >> 1) & NOT_LAST_COL) |
+                   (bb << N) | (bb >> N) | ((bb << (N + 1)) & NOT_FIRST_COL) |
+                   ((bb >> (N + 1)) & NOT_LAST_COL);
+    return out & ALL;
+  }
+
+  static Bitboard flood(const Bitboard seed, const Bitboard own) {
+    Bitboard reach = seed & own;
+    while (true) {
+      Bitboard next = (reach | expand(reach)) & own;
+      if (next == reach) {
+        return reach;
+      }
+      reach = next;
+    }
+  }
+
+  static bool connected(const Bitboard own, const Player player) {
+    const Bitboard start = player == RED ? col_mask(0) : row_mask(0);
+    const Bitboard dest = player == RED ? col_mask(N - 1) : row_mask(N - 1);
+
+    Bitboard reach = own & start;
+    while (reach) {
+      if (reach & dest) {
+        return true;
+      }
+      Bitboard next = (reach | expand(reach)) & own;
+      if (next == reach) {
+        return false;
+      }
+      reach = next;
+    }
+    return false;
+  }
+
+  // the stone sits at its padded position already, so every neighbor of
+  // the same color or on one of its sides is a plain offset away
+  static void unite_stone(Board &board, const int id, const Player player) {
+    const int pos = LAYOUT.to_padded[id];
+    const uint8_t start = border_start(player);
+    const uint8_t dest = border_dest(player);
+    for (int offset : PAD_OFFSETS) {
+      const uint8_t value = board.padded[pos + offset];
+      if (value == player || value == start || value == dest) {
+        board.uf.unite(pos, pos + offset);
+      }
+    }
+  }
+
+  // a cell wins when it touches both the stones reached from the start
+  // edge (or the edge itself) and those reached from the destination edge,
+  // so two floods give every winning cell at once
+  static Bitboard winning_cells(const Bitboard own, const Bitboard empty,
+                                const Player player) {
+    const Bitboard start = player == RED ? col_mask(0) : row_mask(0);
+    const Bitboard dest = player == RED ? col_mask(N - 1) : row_mask(N - 1);
+    const Bitboard from_start = flood(own & start, own);
+    const Bitboard from_dest = flood(own & dest, own);
+    return empty & (expand(from_start) | start) & (expand(from_dest) | dest);
+  }
+};
+
+// Kernels<N> functions for the size of a parsed board
+struct KernelTable {
+  const int16_t *to_padded;
+  int (*neighbors)(const int id, int (&arr_out)[6]);
+  bool (*connected)(const Bitboard own, const Player player);
+  void (*unite_stone)(Board &board, const int id, const Player player);
+  Bitboard (*winning_cells)(const Bitboard own, const Bitboard empty,
+                            const Player player);
+};
+
+// the single dispatch on the board size
+const KernelTable *kernels_for_size(const int size);
@@ -1,111 +1,172 @@
+#include "batch.h"
+#include "binary.h"
 #include "board.h"
-#include <cstdio>
+#include "commands.h"
+#include "io.h"
+#include "parallel_search.h"
+#include "server.h"
+#include "solutions.h"
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <thread>
+#include <unistd.h>
 
-#define MAX_LINE_LEN 70
-#define DEBUG false
-
-void print_bool(bool val) {
-  if (val)
-    std::cout << "YES";
-  else
-    std::cout << "NO";
-}
-
-bool string_startswith(const char *str, const char *prefix) {
-  return strncmp(str, prefix, strlen(prefix)) == 0;
-}
+int main(int argc, char **argv) {
+  int threads = 1;
+  bool batch = false;
+  const char *path = nullptr;
+  const char *stats_path = nullptr;
+  bool stats_per_board = false;
+  bool stats_perf = false;
+  const char *cache_path = nullptr;
+  const char *solutions_path = nullptr;
+  bool encode = false;
+  bool decode = false;
+  const char *socket_path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-b") == 0) {
+      // boards are answered in parallel instead of a single search
+      batch = true;
+    } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      // -t 0 uses every core
+      threads = atoi(argv[++i]);
+      if (threads <= 0) {
+        threads = std::thread::hardware_concurrency();
+      }
+    } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      // stats of all boards at exit, "-" is stderr
+      stats_path = argv[++i];
+    } else if (strcmp(argv[i], "-B") == 0) {
+      // and of every board once it is answered
+      stats_per_board = true;
+    } else if (strcmp(argv[i], "-P") == 0) {
+      // hardware counters around every command
+      stats_perf = true;
+    } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+      // CAN_* answers kept in this file across runs
+      cache_path = argv[++i];
+    } else if (strcmp(argv[i], "-D") == 0 && i + 1 < argc) {
+      // precomputed answers of the small sizes, see make solutions
+      solutions_path = argv[++i];
+    } else if (strcmp(argv[i], "-e") == 0) {
+      // writes the text input in the binary format instead of answering
+      encode = true;
+    } else if (strcmp(argv[i], "-d") == 0) {
+      // writes the binary input as text instead of answering
+      decode = true;
+    } else if (strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+      // serves clients on this unix socket instead of reading the input
+      socket_path = argv[++i];
+    } else if (argv[i][0] != '-' && path == nullptr) {
+      path = argv[i];
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [-b] [-t threads] [-s stats.json] [-B] [-P] [-c cache] "
+                   "[-D solutions.db] [-e | -d] [-u socket] [file]\n"
+                << "boards up to " << MAX_SIZE << "x" << MAX_SIZE
+                << MAX_SIZE_HINT "\n";
+      return 1;
+    }
+  }
 
-void command(Board &board, char *cmd) {
-  if (cmd[0] == '\0') {
-    return;
+  bool want_stats = stats_path != nullptr || stats_per_board || stats_perf;
+  if (want_stats && !USE_STATS) {
+    std::cerr << "stats are compiled out, build with make stats\n";
+    return 1;
   }
-  if (DEBUG) {
-    std::cout << "c: " << cmd << ": ";
+  if (USE_STATS) {
+    stats_init(stats_path != nullptr ? stats_path : "-", stats_per_board,
+               stats_perf);
   }
 
-  if (strcmp(cmd, "BOARD_SIZE") == 0) {
-    std::cout << board.size;
-  } else if (strcmp(cmd, "PAWNS_NUMBER") == 0) {
-    std::cout << board.red_count + board.blue_count;
-  } else if (strcmp(cmd, "IS_BOARD_CORRECT") == 0) {
-    print_bool(board.is_board_correct());
-  } else if (strcmp(cmd, "IS_GAME_OVER") == 0) {
-    Player winner = board.winner();
-    switch (winner) {
-    case NONE:
-      std::cout << "NO";
-      break;
-    case RED:
-      std::cout << "YES RED";
-      break;
-    case BLUE:
-      std::cout << "YES BLUE";
-      break;
+  std::unique_ptr<ResultCache> cache;
+  if (cache_path != nullptr) {
+    cache.reset(new ResultCache());
+    if (!cache->open(cache_path, CACHE_DEFAULT_BITS)) {
+      std::cerr << "can not open the result cache " << cache_path << "\n";
+      return 1;
     }
-  } else if (strcmp(cmd, "IS_BOARD_POSSIBLE") == 0) {
-    print_bool(board.is_board_possible());
-  } else if (string_startswith(cmd, "CAN_")) {
-    Player player;
-    char player_str[MAX_LINE_LEN];
-    char opponent_str[MAX_LINE_LEN];
+  }
 
-    bool one_move = sscanf(cmd, "CAN_%[^_]_WIN_IN_1_MOVE_WITH_%[^_]_OPPONENT",
-                           player_str, opponent_str) == 2;
-    bool two_move = sscanf(cmd, "CAN_%[^_]_WIN_IN_2_MOVES_WITH_%[^_]_OPPONENT",
-                           player_str, opponent_str) == 2;
-    if (strcmp(player_str, "RED") == 0) {
-      player = RED;
-    } else if (strcmp(player_str, "BLUE") == 0) {
-      player = BLUE;
-    } else {
-      std::cerr << "Invalid player: " << player_str << "\n";
-      return;
+  std::unique_ptr<SolutionTable> solutions;
+  if (solutions_path != nullptr) {
+    solutions.reset(new SolutionTable());
+    if (!solutions->open(solutions_path)) {
+      std::cerr << "can not open the solution table " << solutions_path
+                << ", make solutions writes it\n";
+      return 1;
     }
+  }
 
-    bool perfect_op = strcmp(opponent_str, "PERFECT") == 0;
+  if (socket_path != nullptr) {
+    return run_server(socket_path, threads, cache.get(), solutions.get());
+  }
 
-    bool res = false;
-    if (one_move) {
-      res = board.can_player_win_in_one_move(player, perfect_op);
-    } else if (two_move) {
-      res = board.can_player_win_in_two_moves(player, perfect_op);
-    } else {
-      std::cerr << "Invalid command: " << cmd << "\n";
-      return;
+  // a file is memory-mapped, stdin is read in large blocks
+  InputBuffer in;
+  if (path == nullptr) {
+    in.open_fd(STDIN_FILENO);
+  } else if (!in.open_file(path)) {
+    std::cerr << "can not open " << path << "\n";
+    return 1;
+  }
+  OutputBuffer out(STDOUT_FILENO);
+
+  // binary input is told apart from text by its header
+  bool binary = binary_detect(in);
+  if (binary && !binary_read_header(in)) {
+    return 1;
+  }
+  if (encode || decode) {
+    if (encode == binary) {
+      std::cerr << "the input is " << (binary ? "binary" : "text")
+                << " already\n";
+      return 1;
     }
-    if (res) {
-      std::cout << "YES";
+    if (encode) {
+      convert_to_binary(in, out);
     } else {
-      std::cout << "NO";
+      convert_to_text(in, out);
     }
+    return 0;
   }
-  std::cout << "\n";
-}
-void run_once(Board &board) {
-  board.parse_from_stdin();
-
-  char buffer[MAX_LINE_LEN];
-  std::cin.getline(buffer, sizeof(buffer));
-
-  while (!std::cin.eof() && buffer[0] != '-' && buffer[0] != ' ') {
-    command(board, buffer);
 
-    std::cin.getline(buffer, sizeof(buffer));
+  if (batch) {
+    run_batch(in, out, threads, cache.get(), solutions.get(), binary);
+    if (USE_STATS) {
+      stats_finish();
+    }
+    return 0;
   }
-}
 
-int main() {
   Board board;
+  board.cache = cache.get();
+  board.solutions = solutions.get();
+  std::unique_ptr<ParallelSearch> parallel;
+  if (threads > 1) {
+    parallel.reset(new ParallelSearch(threads));
+    board.parallel = parallel.get();
+  }
 
-  // skip ---
-  char buffer[MAX_LINE_LEN];
-  std::cin.getline(buffer, sizeof(buffer));
+  if (binary) {
+    while (run_binary_once(board, in, out)) {
+    }
+  } else {
+    // skip ---
+    const char *line;
+    size_t len;
+    in.next_line(line, len);
 
-  while (!std::cin.eof()) {
-    run_once(board);
+    while (!in.at_end()) {
+      run_once(board, in, out);
+    }
   }
 
+  if (USE_STATS) {
+    out.flush();
+    stats_finish();
+  }
   return 0;
 }
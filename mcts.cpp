@@ -0,0 +1,271 @@
+#include "mcts.h"
+#include "kernels.h"
+#include "parallel_search.h"
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <cmath>
+
+static uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// xorshift64*, a playout draws a few hundred of these
+static uint64_t next_random(uint64_t &state) {
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 0x2545f4914f6cdd1dull;
+}
+
+// uniform in [0, bound)
+static int random_below(uint64_t &state, const int bound) {
+  return ((next_random(state) >> 32) * (uint64_t)bound) >> 32;
+}
+
+MctsTree::MctsTree() : capacity(0), node_count(0), playouts(0) {}
+
+// a leaf is only expanded once MCTS_EXPAND_VISITS playouts ended in it,
+// and an expansion adds at most a child per empty cell of the root
+static int tree_capacity(const int playouts, const int empty) {
+  if (playouts <= 0) {
+    return MCTS_MAX_NODES;
+  }
+  const uint64_t nodes =
+      1 + ((uint64_t)playouts / MCTS_EXPAND_VISITS + 1) * empty;
+  return nodes < MCTS_MAX_NODES ? (int)nodes : MCTS_MAX_NODES;
+}
+
+void MctsTree::reset(const Board &board, const Player new_player,
+                     const int new_playouts, const int ms) {
+  const Bitboard empty = board.masks.all & ~(board.red_bits | board.blue_bits);
+  capacity = tree_capacity(new_playouts, bb_popcount(empty));
+  nodes.reset(new MctsNode[capacity]);
+  player = new_player;
+  max_playouts = new_playouts > 0 ? new_playouts : INT_MAX;
+  deadline_ns = ms > 0 ? now_ns() + (uint64_t)ms * 1000000 : 0;
+  playouts = 0;
+
+  node_count = 1;
+  MctsNode &root = nodes[0];
+  root.stats.store(0, std::memory_order_relaxed);
+  root.rave.store(0, std::memory_order_relaxed);
+  root.move = -1;
+  root.state.store(MCTS_EXPANDING, std::memory_order_relaxed);
+  expand(root, empty);
+}
+
+bool MctsTree::claim_playout() {
+  if (deadline_ns != 0 && now_ns() >= deadline_ns) {
+    return false;
+  }
+  return playouts.fetch_add(1, std::memory_order_relaxed) < max_playouts;
+}
+
+// called by the one thread that moved node to MCTS_EXPANDING, the children
+// are visible to the others once the state is MCTS_EXPANDED
+bool MctsTree::expand(MctsNode &node, const Bitboard empty) {
+  const int count = bb_popcount(empty);
+  if (node_count.load(std::memory_order_relaxed) + count > capacity) {
+    node.state.store(MCTS_FULL, std::memory_order_relaxed);
+    return false;
+  }
+  const int first = node_count.fetch_add(count, std::memory_order_relaxed);
+  if (first + count > capacity) {
+    node.state.store(MCTS_FULL, std::memory_order_relaxed);
+    return false;
+  }
+
+  int i = first;
+  for (Bitboard rest = empty; rest; rest &= rest - 1, i++) {
+    MctsNode &child = nodes[i];
+    child.stats.store(0, std::memory_order_relaxed);
+    child.rave.store(0, std::memory_order_relaxed);
+    child.first_child = 0;
+    child.child_count = 0;
+    child.move = bb_first(rest);
+    child.state.store(MCTS_LEAF, std::memory_order_relaxed);
+  }
+  node.first_child = first;
+  node.child_count = count;
+  node.state.store(MCTS_EXPANDED, std::memory_order_release);
+  return true;
+}
+
+// UCT on a mix of the playouts through the child and its RAVE playouts,
+// moving from RAVE to the child's own as its visits grow
+MctsNode &MctsTree::select(MctsNode &node) {
+  const uint64_t node_stats = node.stats.load(std::memory_order_relaxed);
+  const double log_n = log((double)(node_stats >> 32) + 1);
+  MctsNode *best = nullptr;
+  double best_value = -1;
+  for (int i = 0; i < node.child_count; i++) {
+    MctsNode &child = nodes[node.first_child + i];
+    const uint64_t stats = child.stats.load(std::memory_order_relaxed);
+    const uint64_t rave = child.rave.load(std::memory_order_relaxed);
+    const double n = stats >> 32;
+    const double wins = (uint32_t)stats;
+    const double rave_n = rave >> 32;
+    const double rave_wins = (uint32_t)rave;
+
+    double value = MCTS_FIRST_PLAY;
+    if (n + rave_n > 0) {
+      const double beta = rave_n / (rave_n + n + MCTS_RAVE_BIAS * rave_n * n);
+      value = (n > 0 ? (1 - beta) * wins / n : 0) +
+              (rave_n > 0 ? beta * rave_wins / rave_n : 0);
+    }
+    value += MCTS_UCT_C * sqrt(log_n / (n + 1));
+    if (value > best_value) {
+      best_value = value;
+      best = &child;
+    }
+  }
+  return *best;
+}
+
+// the stones go into local bitboards, board itself is only read, so all
+// threads share it
+void MctsTree::playout(const Board &board, uint64_t &rng) {
+  // indexed by player == BLUE
+  Bitboard bits[2] = {board.red_bits, board.blue_bits};
+  MctsNode *path[MAX_CELLS + 1];
+  int depth = 0;
+
+  MctsNode *node = &nodes[0];
+  node->stats.fetch_add(MCTS_VISIT, std::memory_order_relaxed);
+  path[depth++] = node;
+  Player turn = player;
+  while (node->state.load(std::memory_order_acquire) == MCTS_EXPANDED &&
+         node->child_count > 0) {
+    node = &select(*node);
+    node->stats.fetch_add(MCTS_VISIT, std::memory_order_relaxed);
+    bits[turn == BLUE] |= bb_bit(node->move);
+    turn = opposite_player(turn);
+    path[depth++] = node;
+  }
+
+  const Bitboard empty = board.masks.all & ~(bits[0] | bits[1]);
+  uint8_t leaf = MCTS_LEAF;
+  if ((node->stats.load(std::memory_order_relaxed) >> 32) >=
+          MCTS_EXPAND_VISITS &&
+      node->state.compare_exchange_strong(leaf, MCTS_EXPANDING,
+                                          std::memory_order_acq_rel)) {
+    expand(*node, empty);
+  }
+
+  // fill the board at random, the side to move gets the extra cell of an
+  // odd count; hex has no draws, so exactly one side is connected after
+  int cells[MAX_CELLS];
+  int count = 0;
+  for (Bitboard rest = empty; rest; rest &= rest - 1) {
+    cells[count++] = bb_first(rest);
+  }
+  Bitboard taken = 0;
+  for (int i = 0; i < (count + 1) / 2; i++) {
+    const int j = i + random_below(rng, count - i);
+    const int cell = cells[j];
+    cells[j] = cells[i];
+    cells[i] = cell;
+    taken |= bb_bit(cell);
+  }
+  bits[turn == BLUE] |= taken;
+  bits[turn != BLUE] |= empty & ~taken;
+  const Player winner = board.kernels->connected(bits[0], RED) ? RED : BLUE;
+
+  // path[d] was played by the player for odd d, the visits are already in
+  const Player opponent = opposite_player(player);
+  for (int d = 1; d < depth; d++) {
+    const Player mover = d % 2 == 1 ? player : opponent;
+    if (winner == mover) {
+      path[d]->stats.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // all moves as first: the children of path[d] whose cell their mover
+  // took anywhere after it
+  for (int d = 0; d < depth; d++) {
+    MctsNode &parent = *path[d];
+    if (parent.state.load(std::memory_order_acquire) != MCTS_EXPANDED) {
+      continue;
+    }
+    const Player mover = d % 2 == 0 ? player : opponent;
+    const Bitboard own = bits[mover == BLUE];
+    const uint64_t update = MCTS_VISIT + (winner == mover ? 1 : 0);
+    for (int i = 0; i < parent.child_count; i++) {
+      MctsNode &child = nodes[parent.first_child + i];
+      if (bb_test(own, child.move)) {
+        child.rave.fetch_add(update, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+int MctsTree::best_move() {
+  const MctsNode &root = nodes[0];
+  int best = -1;
+  uint64_t best_visits = 0;
+  for (int i = 0; i < root.child_count; i++) {
+    const MctsNode &child = nodes[root.first_child + i];
+    const uint64_t visits =
+        child.stats.load(std::memory_order_relaxed) >> 32;
+    if (best < 0 || visits > best_visits) {
+      best = child.move;
+      best_visits = visits;
+    }
+  }
+  return best;
+}
+
+static void run_playouts(MctsTree &tree, const Board &board,
+                         const int worker) {
+  uint64_t rng = board.hash ^ ((uint64_t)(worker + 1) * 0x9e3779b97f4a7c15ull);
+  if (rng == 0) {
+    rng = 1;
+  }
+  while (tree.claim_playout()) {
+    tree.playout(board, rng);
+  }
+}
+
+int Board::genmove(const Player player, const int playouts, const int ms,
+                   int &played) {
+  assert(player != NONE);
+  played = 0;
+  if (is_player_connected(RED) || is_player_connected(BLUE)) {
+    return -1;
+  }
+  const Bitboard empty = masks.all & ~(red_bits | blue_bits);
+  if (empty == 0) {
+    return -1;
+  }
+  // nothing to search for
+  const Bitboard wins = winning_cells(player);
+  if (wins) {
+    return bb_first(wins);
+  }
+
+  // every worker takes this one, it is gone after the move
+  MctsTree shared;
+  shared.reset(*this, player, playouts, ms);
+  if (parallel != nullptr) {
+    // tree parallelism: every worker descends the same tree
+    for (int w = 0; w < parallel->pool.size(); w++) {
+      parallel->pool.submit(
+          [this, &shared](int worker) { run_playouts(shared, *this, worker); });
+    }
+    parallel->pool.wait();
+  } else {
+    run_playouts(shared, *this, 0);
+  }
+
+  played = shared.playouts.load();
+  if (played > shared.max_playouts) {
+    played = shared.max_playouts;
+  }
+  if (USE_STATS) {
+    stats.playouts += played;
+  }
+  return shared.best_move();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "board.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// playouts through a leaf before its children are added
+#define MCTS_EXPAND_VISITS 4
+// nodes of one tree at most, a timed GENMOVE gets all of them; a full
+// tree stops growing but keeps playing out
+#define MCTS_MAX_NODES (1 << 20)
+// exploration weight of UCT
+#define MCTS_UCT_C 0.25
+// b^2 of the RAVE schedule, the smaller the longer RAVE values count
+#define MCTS_RAVE_BIAS 0.0025
+// value of a child with no playouts and no RAVE playouts yet
+#define MCTS_FIRST_PLAY 1.0
+
+// visits in the high 32 bits and wins in the low ones, so one atomic add
+// updates both
+#define MCTS_VISIT ((uint64_t)1 << 32)
+
+enum MctsState : uint8_t {
+  MCTS_LEAF,
+  MCTS_EXPANDING,
+  MCTS_EXPANDED,
+  // the tree ran out of nodes
+  MCTS_FULL,
+};
+
+// a move, counted for the player who made it
+// rave counts the playouts in which that player took the cell later on
+struct MctsNode {
+  std::atomic<uint64_t> stats;
+  std::atomic<uint64_t> rave;
+  // children are nodes [first_child, first_child + child_count)
+  int32_t first_child;
+  int16_t child_count;
+  int16_t move;
+  std::atomic<uint8_t> state;
+};
+
+// shared by the threads of one GENMOVE, node 0 is the root; the nodes
+// are allocated by reset for that search and freed with the tree
+// threads descend concurrently; a visit is counted on the way down, so
+// until its playout ends it counts as a loss (virtual loss) and steers the
+// other threads elsewhere
+struct MctsTree {
+  std::unique_ptr<MctsNode[]> nodes;
+  int capacity;
+  std::atomic<int> node_count;
+
+  // the search
+  Player player;
+  int max_playouts;
+  // steady clock ns, 0 for no time limit
+  uint64_t deadline_ns;
+  std::atomic<int> playouts;
+
+  MctsTree();
+  // the tree of board's position with player to move, the root expanded,
+  // with as many nodes as the playouts can add
+  void reset(const Board &board, const Player player, const int playouts,
+             const int ms);
+  // false once the playouts or the time are used up
+  bool claim_playout();
+  // children of node, one per empty cell, false if the tree is full
+  bool expand(MctsNode &node, const Bitboard empty);
+  MctsNode &select(MctsNode &node);
+  // one descent, playout and update, on the stones of board
+  void playout(const Board &board, uint64_t &rng);
+  // the root move with the most visits, -1 if there is none
+  int best_move();
+};
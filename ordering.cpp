@@ -0,0 +1,58 @@
+#include "ordering.h"
+#include <algorithm>
+#include <cstring>
+
+MoveOrdering::MoveOrdering() { clear(); }
+
+void MoveOrdering::clear() {
+  memset(history, 0, sizeof(history));
+  memset(killers, -1, sizeof(killers));
+}
+
+void MoveOrdering::cutoff(const int side, const int moves, const int id) {
+  int16_t *slots = killers[side][std::min(moves, KILLER_DEPTHS - 1)];
+  if (slots[0] != id) {
+    slots[1] = slots[0];
+    slots[0] = id;
+  }
+
+  // cutoffs high up save more work; moves is whatever the query asked
+  // for, so it is capped like the killer depth to keep the sum in range
+  const int weight = std::min(moves, KILLER_DEPTHS);
+  history[side][id] += weight * weight;
+  if (history[side][id] > HISTORY_MAX) {
+    for (uint32_t &score : history[side]) {
+      score /= 2;
+    }
+  }
+}
+
+int MoveOrdering::order(const int side, const int moves, Bitboard cells,
+                        const Bitboard urgent, const Bitboard threats,
+                        int *out) {
+  const int16_t *slots = killers[side][std::min(moves, KILLER_DEPTHS - 1)];
+  // score above the id, the lower id first among equal scores
+  uint64_t keys[MAX_CELLS];
+  int count = 0;
+  for (; cells; cells &= cells - 1) {
+    const int id = bb_first(cells);
+    uint64_t score = history[side][id];
+    if (bb_test(urgent, id)) {
+      score += 1ull << 24;
+    }
+    if (id == slots[0]) {
+      score += 1ull << 23;
+    } else if (id == slots[1]) {
+      score += 1ull << 22;
+    }
+    if (bb_test(threats, id)) {
+      score += 1ull << 21;
+    }
+    keys[count++] = (score << 16) | (0xffff - id);
+  }
+  std::sort(keys, keys + count, [](uint64_t a, uint64_t b) { return a > b; });
+  for (int i = 0; i < count; i++) {
+    out[i] = 0xffff - (int)(keys[i] & 0xffff);
+  }
+  return count;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "bitboard.h"
+#include <cstdint>
+
+// killers are kept per number of moves left, deeper searches share the last
+#define KILLER_DEPTHS 16
+#define KILLER_SLOTS 2
+// a side's history is halved once a score passes this, so recent cutoffs
+// weigh more than old ones
+#define HISTORY_MAX (1u << 20)
+
+// the player's moves, and the opponent's replies
+enum OrderingSide {
+  SIDE_PLAYER,
+  SIDE_OPPONENT,
+};
+
+// cells that decided nodes before are tried first: a move that won for
+// the player, or a reply that refuted it
+// killers are the last two per depth, history sums them up over the
+// whole board, both live as long as the board's transposition table
+struct MoveOrdering {
+  uint32_t history[2][MAX_CELLS];
+  int16_t killers[2][KILLER_DEPTHS][KILLER_SLOTS];
+
+  MoveOrdering();
+
+  void clear();
+  // id decided a node with `moves` moves left
+  void cutoff(const int side, const int moves, const int id);
+  // the cells, urgent ones first, then killers, then threats, the rest
+  // after; by history within each, then by id
+  // returns how many were written to out
+  int order(const int side, const int moves, Bitboard cells,
+            const Bitboard urgent, const Bitboard threats, int *out);
+};
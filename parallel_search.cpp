@@ -0,0 +1,161 @@
+#include "parallel_search.h"
+
+ParallelSearch::ParallelSearch(const int thread_count)
+    : pool(thread_count), boards(thread_count), stop(false),
+      counts(thread_count) {
+  children.reserve(MAX_CELLS);
+  for (Board &board : boards) {
+    board.abort_flag = &stop;
+  }
+}
+
+// board has already passed the checks in Board::can_player_win_in_n_moves
+// turn is the side to move at the root
+bool ParallelSearch::can_player_win_in_n_moves(Board &board,
+                                               const Player query_player,
+                                               const Player turn,
+                                               const int query_moves,
+                                               bool query_perfect_op) {
+  player = query_player;
+  moves = query_moves;
+  perfect_op = query_perfect_op;
+  player_turn = turn == player;
+  mover = player_turn ? player : opposite_player(player);
+  all_must_win = !player_turn && perfect_op;
+
+  // a perfect opponent replies anywhere, like a player move
+  std::vector<int> &root_moves =
+      player_turn || perfect_op ? board.player_moves : board.naive_op_moves;
+
+  children.clear();
+  Bitboard mover_wins = board.winning_cells(mover);
+  for (int id : root_moves) {
+    if (board.cells[id] != NONE) {
+      continue;
+    }
+    if (bb_test(mover_wins, id)) {
+      if (all_must_win) {
+        // the opponent just wins
+        return false;
+      }
+      // ends the game early, can not help the player
+      continue;
+    }
+    children.push_back(id);
+  }
+
+  if (all_must_win && USE_HSEARCH) {
+    Bitboard replies;
+    if (board.vc_must_play(player, moves, replies)) {
+      return true;
+    }
+    int kept = 0;
+    for (int id : children) {
+      if (bb_test(replies, id)) {
+        children[kept++] = id;
+      }
+    }
+    children.resize(kept);
+  }
+
+  if (player_turn && !board.can_run_out_of_replies(moves, perfect_op, false) &&
+      board.stones_needed(player, moves) == moves) {
+    Bitboard candidates = board.short_path_cells(player, moves);
+    int kept = 0;
+    for (int id : children) {
+      if (bb_test(candidates, id)) {
+        children[kept++] = id;
+      }
+    }
+    children.resize(kept);
+  }
+
+  for (Board &worker : boards) {
+    bool same_board = worker.board_id == board.board_id;
+    worker.copy_position(board);
+    if (!same_board) {
+      worker.tt.clear();
+      worker.ordering.clear();
+    }
+  }
+
+  stop = false;
+  result = all_must_win;
+
+  for (int id : children) {
+    // small enough a capture for std::function to keep it inline
+    pool.submit([this, id](int w) { search_child(w, id); });
+  }
+  pool.wait();
+
+  if (USE_STATS) {
+    for (Board &worker : boards) {
+      board.stats.add(worker.stats);
+      worker.stats.clear();
+    }
+  }
+  return result;
+}
+
+void ParallelSearch::search_child(const int w, const int id) {
+  if (stop) {
+    return;
+  }
+  Board &worker = boards[w];
+  worker.create_uf();
+
+  int mark = worker.uf.mark();
+  worker.place_stone(id, mover);
+  bool can_win = player_turn
+                     ? worker.search_op_turn(player, moves - 1, perfect_op)
+                     : worker.search_p_turn(player, moves, perfect_op);
+  worker.remove_stone(id, mark);
+
+  if (stop) {
+    // cut off by another worker, can_win is meaningless
+    return;
+  }
+  if (can_win != all_must_win) {
+    result = can_win;
+    stop = true;
+  }
+}
+
+void ParallelSearch::count_positions(Board &board, const Player turn,
+                                     const int depth, PositionCounts &total) {
+  for (Board &worker : boards) {
+    worker.copy_position(board);
+  }
+  for (PositionCounts &worker_counts : counts) {
+    worker_counts.clear();
+  }
+
+  for (int id : board.player_moves) {
+    if (board.cells[id] != NONE) {
+      continue;
+    }
+    pool.submit([this, id, turn, depth](int w) {
+      Board &worker = boards[w];
+      PositionCounts &worker_counts = counts[w];
+      worker.create_uf();
+      if (!bb_test(worker.sensible_bits, id)) {
+        worker_counts.pruned++;
+      }
+
+      int mark = worker.uf.mark();
+      if (worker.place_stone(id, turn)) {
+        (turn == RED ? worker_counts.red_wins : worker_counts.blue_wins)++;
+      } else {
+        worker.count_positions_from(opposite_player(turn), depth - 1,
+                                    worker_counts);
+      }
+      worker.remove_stone(id, mark);
+    });
+  }
+  pool.wait();
+
+  total.clear();
+  for (const PositionCounts &worker_counts : counts) {
+    total.add(worker_counts);
+  }
+}
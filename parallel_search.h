@@ -0,0 +1,39 @@
+#pragma once
+
+#include "board.h"
+#include "perft.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <vector>
+
+// splits the root of a CAN_* search across a work-stealing pool
+// every worker searches on its own copy of the board, and all of them
+// stop as soon as one root move decides the answer
+struct ParallelSearch {
+  ThreadPool pool;
+  std::vector<Board> boards;
+  std::atomic<bool> stop;
+
+  // the query being searched, shared by all tasks
+  Player player, mover;
+  int moves;
+  bool perfect_op, player_turn;
+  // and-node: the perfect opponent has to be refuted on every move
+  bool all_must_win;
+  std::atomic<bool> result;
+  // root moves worth searching, reused between queries
+  std::vector<int> children;
+  // COUNT_POSITIONS of each worker
+  std::vector<PositionCounts> counts;
+
+  ParallelSearch(const int thread_count);
+
+  bool can_player_win_in_n_moves(Board &board, const Player player,
+                                 const Player turn, const int moves,
+                                 bool perfect_op);
+  void search_child(const int worker, const int id);
+
+  // one task per first move, board has its moves and union-find created
+  void count_positions(Board &board, const Player turn, const int depth,
+                       PositionCounts &total);
+};
@@ -0,0 +1,63 @@
+#include "perft.h"
+#include "board.h"
+#include "parallel_search.h"
+
+void PositionCounts::clear() {
+  leaves = 0;
+  red_wins = 0;
+  blue_wins = 0;
+  pruned = 0;
+  checksum = 0;
+}
+
+void PositionCounts::add(const PositionCounts &other) {
+  leaves += other.leaves;
+  red_wins += other.red_wins;
+  blue_wins += other.blue_wins;
+  pruned += other.pruned;
+  checksum += other.checksum;
+}
+
+// every empty cell in the order the searches walk them, made and unmade
+// with the same place_stone / remove_stone
+void Board::count_positions_from(const Player turn, const int depth,
+                                 PositionCounts &counts) {
+  if (depth == 0) {
+    counts.leaves++;
+    counts.checksum += hash;
+    return;
+  }
+  for (int id : player_moves) {
+    if (cells[id] != NONE) {
+      continue;
+    }
+    if (!bb_test(sensible_bits, id)) {
+      counts.pruned++;
+    }
+
+    int mark = uf.mark();
+    if (place_stone(id, turn)) {
+      (turn == RED ? counts.red_wins : counts.blue_wins)++;
+    } else {
+      count_positions_from(opposite_player(turn), depth - 1, counts);
+    }
+    remove_stone(id, mark);
+  }
+}
+
+void Board::count_positions(const int depth, PositionCounts &counts) {
+  counts.clear();
+  // a finished game has no continuations
+  if (is_player_connected(RED) || is_player_connected(BLUE)) {
+    (is_player_connected(RED) ? counts.red_wins : counts.blue_wins)++;
+    return;
+  }
+  create_moves();
+  create_uf();
+
+  if (parallel != nullptr && depth >= 2) {
+    parallel->count_positions(*this, curr_turn(), depth, counts);
+  } else {
+    count_positions_from(curr_turn(), depth, counts);
+  }
+}
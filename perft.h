@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+// what COUNT_POSITIONS found below a position
+struct PositionCounts {
+  // positions exactly `depth` moves on, nobody connected
+  uint64_t leaves;
+  // continuations that ended with a connection, counted and not extended
+  uint64_t red_wins;
+  uint64_t blue_wins;
+  // moves made that are not in sensible_moves, into cells with no stone
+  // or edge next to them at the start
+  uint64_t pruned;
+  // sum of the hashes of the leaves, the same in any order
+  uint64_t checksum;
+
+  void clear();
+  void add(const PositionCounts &other);
+};
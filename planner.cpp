@@ -0,0 +1,108 @@
+#include "planner.h"
+#include "commands.h"
+#include <cstring>
+
+QueryPlan::QueryPlan() : count(0) {}
+
+bool QueryPlan::full() { return count == PLAN_MAX_QUERIES; }
+
+void QueryPlan::add(const char *line, const size_t len) {
+  PlannedQuery &query = queries[count++];
+  memcpy(query.line, line, len);
+  query.line[len] = '\0';
+  query.is_can = string_startswith(query.line, "CAN_");
+  query.invalid = false;
+  query.answered = false;
+  if (query.is_can) {
+    query.invalid = !parse_can_query(query.line, query.player, query.moves,
+                                     query.perfect_op);
+  }
+}
+
+// every not yet answered query asking the same
+void QueryPlan::set_answer(const Player player, const int moves,
+                           const bool perfect_op, const bool answer) {
+  for (int i = 0; i < count; i++) {
+    PlannedQuery &query = queries[i];
+    if (query.is_can && !query.invalid && !query.answered &&
+        query.player == player && query.moves == moves &&
+        query.perfect_op == perfect_op) {
+      query.answered = true;
+      query.answer = answer;
+    }
+  }
+}
+
+void QueryPlan::resolve(Board &board, const int index) {
+  PlannedQuery &query = queries[index];
+  const Player player = query.player;
+  const int moves = query.moves;
+  const bool perfect_op = query.perfect_op;
+
+  StatsProbe probe;
+  if (USE_STATS) {
+    probe.start();
+  }
+  if (!query.answered) {
+    bool answer = board.can_player_win_in_n_moves(player, moves, perfect_op);
+    set_answer(player, moves, perfect_op, answer);
+
+    const bool player_first = board.curr_turn() == player;
+    if (moves == 1 && player_first) {
+      set_answer(player, moves, !perfect_op, answer);
+    } else if (perfect_op && answer) {
+      // every reply the perfect opponent may make loses, and there is
+      // one, so a naive opponent has one too
+      // (the answer may come from the cache, before the moves exist)
+      board.create_moves();
+      if (!board.can_run_out_of_replies(moves, true, !player_first)) {
+        set_answer(player, moves, false, true);
+      }
+    }
+  }
+  if (USE_STATS) {
+    probe.stop(board.stats, query.line);
+  }
+}
+
+static bool runs_before(const PlannedQuery &a, const PlannedQuery &b) {
+  if (a.moves != b.moves) {
+    return a.moves < b.moves;
+  }
+  return a.perfect_op && !b.perfect_op;
+}
+
+void QueryPlan::run(Board &board, OutputBuffer &out) {
+  int order[PLAN_MAX_QUERIES];
+  int can_count = 0;
+  for (int i = 0; i < count; i++) {
+    if (queries[i].is_can && !queries[i].invalid) {
+      order[can_count++] = i;
+    }
+  }
+  // the cheap ones first, perfect before naive; an insertion sort, as it
+  // is stable and needs no buffer (std::stable_sort allocates one)
+  for (int i = 1; i < can_count; i++) {
+    int index = order[i];
+    int j = i;
+    while (j > 0 && runs_before(queries[index], queries[order[j - 1]])) {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = index;
+  }
+  for (int i = 0; i < can_count; i++) {
+    resolve(board, order[i]);
+  }
+
+  for (int i = 0; i < count; i++) {
+    const PlannedQuery &query = queries[i];
+    if (!query.is_can) {
+      command(board, query.line, out);
+    } else if (!query.invalid) {
+      print_bool(query.answer, out);
+      out.write("\n", 1);
+    }
+  }
+  count = 0;
+}
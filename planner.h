@@ -0,0 +1,48 @@
+#pragma once
+
+#include "board.h"
+#include "io.h"
+#include <cstddef>
+
+// the queries of a board are read ahead and answered together
+#define USE_PLANNER true
+
+// query lines kept at once, a board with more is answered in chunks
+#define PLAN_MAX_QUERIES 64
+
+struct PlannedQuery {
+  char line[MAX_LINE_LEN];
+  // CAN_* queries are planned, the rest go to command() when printed
+  bool is_can;
+  // an invalid CAN_* line prints nothing, like in command()
+  bool invalid;
+  Player player;
+  int moves;
+  bool perfect_op;
+
+  bool answered;
+  bool answer;
+};
+
+// answers the CAN_* queries of a board in an order where the answer of
+// one can decide others, then prints every answer in the input order
+// - duplicates are searched once
+// - with the player to move, 1 move does not depend on the opponent
+// - perfect opponent queries go first, a YES of one is a YES of the naive
+//   query as long as the perfect opponent can not run out of replies
+// the position, moves, union-find and transposition table of the board
+// are shared by all of them
+struct QueryPlan {
+  PlannedQuery queries[PLAN_MAX_QUERIES];
+  int count;
+
+  QueryPlan();
+  bool full();
+  void add(const char *line, const size_t len);
+  // answers, prints and forgets the queries added so far
+  void run(Board &board, OutputBuffer &out);
+
+  void resolve(Board &board, const int index);
+  void set_answer(const Player player, const int moves, const bool perfect_op,
+                  const bool answer);
+};
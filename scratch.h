@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// independent buffers per Scratch, so a walk can run while an outer one
+// is still using its own level
+#define SCRATCH_LEVELS 4
+
+// set of cell ids (or padded positions) with an O(1) clear
+// a cell is in the set iff its stamp equals the current epoch
+template <int N> struct EpochVisited {
+  uint32_t stamps[N];
+  uint32_t epoch;
+
+  EpochVisited() : epoch(1) { memset(stamps, 0, sizeof(stamps)); }
+
+  void clear() {
+    epoch++;
+    if (epoch == 0) {
+      // wrapped around, old stamps could match again
+      memset(stamps, 0, sizeof(stamps));
+      epoch = 1;
+    }
+  }
+  bool test(const int id) const { return stamps[id] == epoch; }
+  void set(const int id) { stamps[id] = epoch; }
+};
+
+// preallocated visited sets and stacks for the graph walks of a board,
+// every cell is pushed at most once per walk so N entries are enough
+template <int N> struct Scratch {
+  EpochVisited<N> visited[SCRATCH_LEVELS];
+  int stacks[SCRATCH_LEVELS][N];
+};
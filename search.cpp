@@ -0,0 +1,294 @@
+#include "board.h"
+#include "parallel_search.h"
+#include "solutions.h"
+#include <cassert>
+#include <vector>
+
+bool Board::aborted() {
+  return abort_flag != nullptr && abort_flag->load(std::memory_order_relaxed);
+}
+
+int Board::order_moves(const int side, const int moves, const Bitboard cells,
+                       const Bitboard urgent, const Bitboard threats,
+                       int *out) {
+  if (!USE_ORDERING) {
+    int count = 0;
+    for (Bitboard rest = cells; rest; rest &= rest - 1) {
+      out[count++] = bb_first(rest);
+    }
+    return count;
+  }
+  return ordering.order(side, moves, cells, urgent, threats, out);
+}
+
+// the move tried as number `tried` (from 0) decided the node
+void Board::cutoff(const int side, const int moves, const int id,
+                   const int tried) {
+  if (USE_STATS) {
+    stats.cutoffs++;
+    stats.cutoff_moves_tried += tried + 1;
+  }
+  if (USE_ORDERING && !aborted()) {
+    ordering.cutoff(side, moves, id);
+  }
+}
+
+// the player moves, `moves` of their moves are left
+bool Board::search_p_turn(const Player player, const int moves,
+                          bool perfect_op) {
+  if (USE_STATS) {
+    stats.p_turn_nodes++;
+  }
+  if (moves == 1) {
+    return winning_cells(player) != 0;
+  }
+
+  if (aborted()) {
+    return false;
+  }
+
+  uint64_t key = hash ^ zobrist_query(player, moves, perfect_op);
+  bool cached;
+  if (tt.probe(key, cached)) {
+    if (USE_STATS) {
+      stats.tt_hits++;
+    }
+    return cached;
+  }
+
+  // every stone of a win in exactly `moves` is on a path of at most `moves`
+  // stones, with no slack the first one must be on a shortest one
+  const Bitboard empty = masks.all & ~(red_bits | blue_bits);
+  Bitboard candidates = empty;
+  // moves on a shortest path go first
+  Bitboard threats = empty;
+  if (!can_run_out_of_replies(moves, perfect_op, false)) {
+    int needed = stones_needed(player, moves);
+    if (needed > moves) {
+      if (USE_STATS) {
+        stats.distance_cutoffs++;
+      }
+      tt.store(key, moves, false);
+      return false;
+    }
+    if (needed == moves) {
+      candidates = short_path_cells(player, moves);
+    } else if (USE_ORDERING) {
+      threats = short_path_cells(player, needed);
+    }
+  }
+
+  // winning before the last move does not count
+  candidates &= ~winning_cells(player);
+  if (USE_STATS) {
+    stats.pruned_moves += bb_popcount(empty & ~candidates);
+  }
+
+  int order[MAX_CELLS];
+  int count = order_moves(SIDE_PLAYER, moves, candidates, 0, threats, order);
+  bool can_win = false;
+  for (int i = 0; i < count && !can_win; i++) {
+    int mark = uf.mark();
+    place_stone(order[i], player);
+    can_win = search_op_turn(player, moves - 1, perfect_op);
+    remove_stone(order[i], mark);
+
+    if (can_win) {
+      cutoff(SIDE_PLAYER, moves, order[i], i);
+    }
+  }
+
+  // after an abort the result may be garbage, keep it out of the table
+  if (!aborted()) {
+    tt.store(key, moves, can_win);
+  }
+  return can_win;
+}
+
+// the opponent moves, the player still has `moves` moves after it
+bool Board::search_op_turn(const Player player, const int moves,
+                           bool perfect_op) {
+  Player opponent = opposite_player(player);
+
+  if (USE_STATS) {
+    stats.op_turn_nodes++;
+  }
+  if (aborted()) {
+    return false;
+  }
+
+  uint64_t key = hash ^ zobrist_query(player, moves, perfect_op);
+  bool cached;
+  if (tt.probe(key, cached)) {
+    if (USE_STATS) {
+      stats.tt_hits++;
+    }
+    return cached;
+  }
+
+  if (!can_run_out_of_replies(moves, perfect_op, true) &&
+      stones_needed(player, moves) > moves) {
+    if (USE_STATS) {
+      stats.distance_cutoffs++;
+    }
+    tt.store(key, moves, false);
+    return false;
+  }
+
+  // the perfect opponent may reply anywhere: a cell with no stone next to
+  // it at the root can still be the only refutation a few moves deep
+  const Bitboard empty = masks.all & ~(red_bits | blue_bits);
+  bool can_win;
+  if (perfect_op) {
+    // cutoff: a perfect opponent with a winning move takes it
+    can_win = winning_cells(opponent) == 0;
+
+    // replies outside the must-play region lose to a virtual connection
+    Bitboard replies = masks.all;
+
+    // a reply blocks at most one winning cell of the player and creates
+    // none, so only two or more of them win (or no reply at all)
+    if (can_win && moves == 1) {
+      can_win = bb_popcount(winning_cells(player)) >= 2 || empty == 0;
+      replies = 0;
+    } else if (can_win && USE_HSEARCH && vc_must_play(player, moves, replies)) {
+      if (USE_STATS) {
+        stats.vc_proofs++;
+      }
+      replies = 0;
+    }
+
+    // replies that take the player's winning cells or lie on its short
+    // paths are the likely refutations
+    if (USE_STATS && can_win) {
+      stats.pruned_replies += bb_popcount(empty & ~replies);
+    }
+    int order[MAX_CELLS];
+    int count = 0;
+    if (can_win && replies != 0) {
+      Bitboard urgent = USE_ORDERING ? winning_cells(player) : 0;
+      Bitboard threats =
+          USE_ORDERING ? short_path_cells(player, moves) : (Bitboard)0;
+      count = order_moves(SIDE_OPPONENT, moves, empty & replies,
+                          urgent, threats, order);
+    }
+    for (int i = 0; i < count && can_win; i++) {
+      int mark = uf.mark();
+      place_stone(order[i], opponent);
+      can_win = search_p_turn(player, moves, perfect_op);
+      remove_stone(order[i], mark);
+
+      if (!can_win) {
+        cutoff(SIDE_OPPONENT, moves, order[i], i);
+      }
+    }
+  } else {
+    can_win = false;
+    // a naive opponent that wins ends the game, so skip such moves
+    Bitboard op_wins = winning_cells(opponent);
+    for (int id : naive_op_moves) {
+      if (cells[id] != NONE || bb_test(op_wins, id)) {
+        continue;
+      }
+
+      int mark = uf.mark();
+      place_stone(id, opponent);
+      can_win = search_p_turn(player, moves, perfect_op);
+      remove_stone(id, mark);
+
+      if (can_win) {
+        break;
+      }
+    }
+  }
+
+  // after an abort the result may be garbage, keep it out of the table
+  if (!aborted()) {
+    tt.store(key, moves, can_win);
+  }
+  return can_win;
+}
+
+bool Board::can_player_win_in_n_moves(const Player player, const int moves,
+                                      bool perfect_op) {
+  bool can_win;
+  if (solutions != nullptr &&
+      solutions->lookup_can(*this, player == RED, moves, perfect_op,
+                            can_win)) {
+    if (USE_STATS) {
+      stats.solution_hits++;
+    }
+    return can_win;
+  }
+  if (cache == nullptr) {
+    return solve_n_moves(player, moves, perfect_op);
+  }
+  bool swapped;
+  uint64_t key = canonical_key(swapped);
+  int bit = cache_query_bit((player == RED) != swapped, moves, perfect_op);
+  if (bit < 0) {
+    return solve_n_moves(player, moves, perfect_op);
+  }
+
+  if (cache->lookup(key, bit, can_win)) {
+    if (USE_STATS) {
+      stats.cache_hits++;
+    }
+    return can_win;
+  }
+  can_win = solve_n_moves(player, moves, perfect_op);
+  cache->store(key, bit, can_win);
+  return can_win;
+}
+
+bool Board::solve_n_moves(const Player player, const int moves,
+                          bool perfect_op) {
+  assert(player != NONE);
+  assert(moves >= 1);
+  Player turn = curr_turn();
+
+  bool all_occupied = red_count + blue_count == size * size;
+  Player opponent = opposite_player(player);
+
+  bool player_won = is_player_connected(player);
+  bool op_won = is_player_connected(opponent);
+
+  if (all_occupied || player_won || op_won) {
+    return false;
+  }
+
+  create_moves();
+  create_uf();
+
+  // too far from connecting to make it in `moves`
+  if (!can_run_out_of_replies(moves, perfect_op, turn != player) &&
+      stones_needed(player, moves) > moves) {
+    if (USE_STATS) {
+      stats.distance_cutoffs++;
+    }
+    return false;
+  }
+
+  if (USE_HSEARCH && vc_proves_win(player, turn, moves)) {
+    if (USE_STATS) {
+      stats.vc_proofs++;
+    }
+    return true;
+  }
+
+  int &curr_turn_count = curr_player_count();
+  curr_turn_count++;
+  bool can_win;
+  if (parallel != nullptr && !(turn == player && moves == 1)) {
+    // a single player move is just a scan, not worth the threads
+    can_win = parallel->can_player_win_in_n_moves(*this, player, turn, moves,
+                                                  perfect_op);
+  } else if (turn == player) {
+    can_win = search_p_turn(player, moves, perfect_op);
+  } else {
+    can_win = search_op_turn(player, moves, perfect_op);
+  }
+  curr_turn_count--;
+
+  return can_win;
+}
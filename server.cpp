@@ -0,0 +1,161 @@
+#include "server.h"
+#include "batch.h"
+#include "binary.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+struct Server {
+  ThreadPool pool;
+  std::vector<Board> boards;
+
+  Server(const int threads, ResultCache *cache,
+         const SolutionTable *solutions)
+      : pool(threads), boards(threads) {
+    for (Board &board : boards) {
+      board.cache = cache;
+      board.solutions = solutions;
+    }
+  }
+};
+
+// like batch_read_job, but a board also ends at an empty line, as the top
+// line of the next board may not be sent for a while
+// top_read is set when the top line of the next board was consumed
+static bool read_text_request(InputBuffer &in, BatchJob &job,
+                              bool &top_read) {
+  const char *line;
+  size_t len;
+  if (!top_read) {
+    // the top line, after the empty lines between boards
+    do {
+      if (!in.next_line(line, len)) {
+        return false;
+      }
+    } while (len == 0);
+  }
+  top_read = false;
+
+  bool got_bottom = false;
+  while (!got_bottom && in.next_line(line, len)) {
+    job.input.append(line, len);
+    job.input += '\n';
+    got_bottom = is_board_edge(line, len);
+  }
+  if (!got_bottom) {
+    return false;
+  }
+
+  while (in.next_line(line, len) && len > 0) {
+    if (line[0] == '-' || line[0] == ' ') {
+      top_read = true;
+      break;
+    }
+    job.input.append(line, len);
+    job.input += '\n';
+  }
+  return true;
+}
+
+// Board::parse exits on a broken board, a server can not
+static bool text_board_valid(const std::string &input) {
+  int cells = 0;
+  for (size_t i = 0; i + 2 < input.size(); i++) {
+    if (input[i] == '\n' && is_board_edge(input.data() + i + 1,
+                                          input.size() - i - 1)) {
+      break;
+    }
+    if (input[i] != '<') {
+      continue;
+    }
+    char c = input[i + 2];
+    if ((c != 'r' && c != 'b' && c != ' ') || ++cells > MAX_CELLS) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void serve_connection(Server &server, const int fd) {
+  InputBuffer in;
+  in.open_fd(fd);
+  OutputBuffer out(fd);
+  BatchQueue queue;
+  queue.reading_done = false;
+  std::thread writer(batch_write_jobs, std::ref(queue), std::ref(out), true);
+
+  bool binary = binary_detect(in);
+  bool ok = !binary || binary_read_header(in);
+  bool top_read = false;
+  while (ok) {
+    std::shared_ptr<BatchJob> job(new BatchJob());
+    job->binary = binary;
+    bool got_job = binary ? binary_read_record(in, job->input)
+                          : read_text_request(in, *job, top_read);
+    if (!got_job) {
+      break;
+    }
+    if (!binary && !text_board_valid(job->input)) {
+      // answered in order like any other board, then the connection ends
+      const char error[] = "ERROR parse error\n";
+      job->output.assign(error, error + strlen(error));
+      job->done = true;
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.jobs.push_back(job);
+      break;
+    }
+    batch_submit(server.pool, server.boards, queue, job);
+  }
+
+  batch_reading_done(queue);
+  writer.join();
+  close(fd);
+}
+
+int run_server(const char *path, const int threads, ResultCache *cache,
+               const SolutionTable *solutions) {
+  // a client that goes away must not take the server with it
+  signal(SIGPIPE, SIG_IGN);
+
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    std::cerr << "socket path too long: " << path << "\n";
+    return 1;
+  }
+  strcpy(addr.sun_path, path);
+
+  // a socket left behind by an earlier server, but nothing else
+  struct stat st;
+  if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+    unlink(path);
+  }
+
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd < 0 || bind(listen_fd, (sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(listen_fd, SOMAXCONN) != 0) {
+    perror(path);
+    return 1;
+  }
+
+  Server server(threads, cache, solutions);
+  while (true) {
+    int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      perror("accept");
+      return 1;
+    }
+    std::thread(serve_connection, std::ref(server), fd).detach();
+  }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "cache.h"
+#include "solutions.h"
+
+// serves boards and queries over a unix socket at path until the process
+// is killed, returns only if the socket can not be set up
+//
+// a connection sends the same input as stdin, text or binary (told apart
+// by the header); a text board ends at an empty line or at the top line
+// of the next board, so a client can wait for the answers of a board
+// before sending another one
+// the boards of all connections are answered on one pool of `threads`
+// boards, whose preallocated cells, scratch and tables are reused (every
+// parsed board still starts with an empty transposition table), and the
+// answers of every connection go back in its request order as soon as
+// they are ready
+int run_server(const char *path, const int threads, ResultCache *cache,
+               const SolutionTable *solutions);
@@ -0,0 +1,183 @@
+#include "solutions.h"
+#include "board.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// binomials up to the cells of the largest size
+struct Binomials {
+  uint64_t c[SOLUTIONS_MAX_CELLS + 1][SOLUTIONS_MAX_CELLS + 1];
+
+  Binomials() {
+    for (int n = 0; n <= SOLUTIONS_MAX_CELLS; n++) {
+      c[n][0] = 1;
+      for (int k = 1; k <= SOLUTIONS_MAX_CELLS; k++) {
+        c[n][k] = n == 0 ? 0 : c[n - 1][k - 1] + c[n - 1][k];
+      }
+    }
+  }
+};
+
+static const Binomials binomials;
+
+// positions of a size with blue_count blue stones and red_count red ones
+static uint64_t block_len(const int cells, const int red_count,
+                          const int blue_count) {
+  if (red_count + blue_count > cells) {
+    return 0;
+  }
+  return binomials.c[cells][red_count] *
+         binomials.c[cells - red_count][blue_count];
+}
+
+// index of the first position with the counts within its size
+static uint64_t block_first(const int cells, const int red_count,
+                            const int blue_count) {
+  uint64_t first = 0;
+  for (int blue = 0; blue < blue_count; blue++) {
+    first += block_len(cells, blue, blue) + block_len(cells, blue + 1, blue);
+  }
+  if (red_count > blue_count) {
+    first += block_len(cells, blue_count, blue_count);
+  }
+  return first;
+}
+
+void solutions_layout(uint64_t (&first)[SOLUTIONS_MAX_SIZE + 2]) {
+  // no positions of size 0
+  first[0] = 0;
+  first[1] = 0;
+  for (int size = 1; size <= SOLUTIONS_MAX_SIZE; size++) {
+    const int cells = size * size;
+    // every block, up to the blue count of a full board
+    first[size + 1] = first[size] + block_first(cells, cells, cells / 2 + 1);
+  }
+}
+
+struct Layout {
+  uint64_t first[SOLUTIONS_MAX_SIZE + 2];
+
+  Layout() { solutions_layout(first); }
+};
+
+static const Layout layout;
+
+int64_t solution_index(const Board &board) {
+  const int size = board.size;
+  const int red_count = board.red_count;
+  const int blue_count = board.blue_count;
+  if (size < 1 || size > SOLUTIONS_MAX_SIZE ||
+      (red_count != blue_count && red_count != blue_count + 1)) {
+    return -1;
+  }
+  const int count = size * size;
+
+  // colex ranks: the red cells among all, the blue ones among the rest
+  uint64_t red_rank = 0;
+  uint64_t blue_rank = 0;
+  int reds = 0;
+  int blues = 0;
+  int rest = 0;
+  for (int id = 0; id < count; id++) {
+    if (board.cells[id] == RED) {
+      red_rank += binomials.c[id][++reds];
+    } else {
+      if (board.cells[id] == BLUE) {
+        blue_rank += binomials.c[rest][++blues];
+      }
+      rest++;
+    }
+  }
+  return layout.first[size] + block_first(count, red_count, blue_count) +
+         red_rank * binomials.c[count - red_count][blue_count] + blue_rank;
+}
+
+SolutionTable::SolutionTable()
+    : fd(-1), map(nullptr), map_len(0), answers(nullptr), possible(nullptr) {}
+
+SolutionTable::~SolutionTable() {
+  if (map != nullptr) {
+    munmap(map, map_len);
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
+uint64_t solutions_answer_words(const uint64_t positions) {
+  return (positions + 1) / 2 * 2;
+}
+
+static size_t file_len(const uint64_t positions) {
+  return sizeof(SolutionsHeader) +
+         solutions_answer_words(positions) * sizeof(uint32_t) +
+         (positions + 63) / 64 * sizeof(uint64_t);
+}
+
+bool SolutionTable::open(const char *path) {
+  fd = ::open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0 ||
+      (size_t)st.st_size < sizeof(SolutionsHeader)) {
+    return false;
+  }
+  void *mem = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (mem == MAP_FAILED) {
+    return false;
+  }
+  map = mem;
+  map_len = st.st_size;
+
+  const SolutionsHeader &header = *(const SolutionsHeader *)map;
+  if (header.magic != SOLUTIONS_MAGIC || header.version != SOLUTIONS_VERSION ||
+      header.max_size != SOLUTIONS_MAX_SIZE ||
+      header.max_moves != SOLUTIONS_MAX_MOVES) {
+    return false;
+  }
+  for (int size = 0; size <= SOLUTIONS_MAX_SIZE + 1; size++) {
+    if (header.first[size] != layout.first[size]) {
+      return false;
+    }
+    first[size] = header.first[size];
+  }
+  const uint64_t positions = first[SOLUTIONS_MAX_SIZE + 1];
+  if (map_len != file_len(positions)) {
+    return false;
+  }
+  const uint32_t *words =
+      (const uint32_t *)((const char *)map + sizeof(SolutionsHeader));
+  const uint64_t *bits =
+      (const uint64_t *)(words + solutions_answer_words(positions));
+  // the map starts on a page, so this only fails for a wrong layout
+  if ((uintptr_t)bits % alignof(uint64_t) != 0) {
+    return false;
+  }
+  answers = words;
+  possible = bits;
+  return true;
+}
+
+bool SolutionTable::lookup_can(const Board &board, const bool red,
+                               const int moves, const bool perfect_op,
+                               bool &answer) const {
+  const int bit = cache_query_bit(red, moves, perfect_op);
+  if (answers == nullptr || bit < 0) {
+    return false;
+  }
+  const int64_t index = solution_index(board);
+  if (index < 0) {
+    return false;
+  }
+  answer = (answers[index] >> bit) & 1;
+  return true;
+}
+
+bool SolutionTable::lookup_possible(const Board &board, bool &answer) const {
+  const int64_t index = solution_index(board);
+  if (possible == nullptr || index < 0) {
+    return false;
+  }
+  answer = (possible[index / 64] >> (index % 64)) & 1;
+  return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "board.h"
+#include "cache.h"
+#include <cstddef>
+#include <cstdint>
+
+// precomputed answers of every correct position of the small sizes,
+// written by solver/ (make solutions) and memory-mapped by main -D
+//
+// positions of a size are numbered by a minimal perfect hash: by blue
+// count, red count (equal, or one more), then the rank of the red cells
+// among all cells and of the blue cells among the rest
+// the file is a header, a 32-bit word of CAN_* answers per position (bits
+// as in cache_query_bit), padded to an even count, and a bitset of
+// IS_BOARD_POSSIBLE in 64-bit words
+
+// bump whenever an answer could change, like CACHE_VERSION
+#define SOLUTIONS_VERSION 3
+// "HEXSOLVE"
+#define SOLUTIONS_MAGIC 0x45564c4f53584548ull
+// 5x5 has 1.6e11 correct positions, too many to solve
+#define SOLUTIONS_MAX_SIZE 4
+#define SOLUTIONS_MAX_MOVES CACHE_MAX_MOVES
+#define SOLUTIONS_MAX_CELLS (SOLUTIONS_MAX_SIZE * SOLUTIONS_MAX_SIZE)
+
+struct SolutionsHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t max_size;
+  uint32_t max_moves;
+  uint32_t reserved;
+  // index of the first position of every size, and the total at the end
+  uint64_t first[SOLUTIONS_MAX_SIZE + 2];
+};
+
+// the numbering, the same in the solver and main
+void solutions_layout(uint64_t (&first)[SOLUTIONS_MAX_SIZE + 2]);
+// words of the answers section, one per position and a zero one if the
+// count is odd, so the bitset after it is 8-byte aligned
+uint64_t solutions_answer_words(const uint64_t positions);
+// index of the position among all sizes, -1 if it has none: a larger
+// board, or one with a wrong number of stones
+int64_t solution_index(const Board &board);
+
+struct SolutionTable {
+  int fd;
+  void *map;
+  size_t map_len;
+  const uint32_t *answers;
+  const uint64_t *possible;
+  uint64_t first[SOLUTIONS_MAX_SIZE + 2];
+
+  SolutionTable();
+  ~SolutionTable();
+
+  // maps path read-only, false if it is missing or of another version
+  bool open(const char *path);
+
+  // false if the table does not have the position or the query
+  bool lookup_can(const Board &board, const bool red, const int moves,
+                  const bool perfect_op, bool &answer) const;
+  bool lookup_possible(const Board &board, bool &answer) const;
+};
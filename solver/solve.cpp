@@ -0,0 +1,258 @@
+#include "board.h"
+#include "kernels.h"
+#include "solutions.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// cells whose values are split across the tasks of a size, 3^this tasks
+#define SPLIT_CELLS 4
+
+// cells of a position as a bit per cell, enough for the small sizes
+typedef uint32_t CellMask;
+static_assert(SOLUTIONS_MAX_CELLS <= 32, "cells do not fit a CellMask");
+
+struct Solver {
+  std::vector<uint32_t> answers;
+  std::vector<std::atomic<uint64_t>> possible;
+  std::vector<Board> boards;
+  std::atomic<uint64_t> solved;
+  // of the size being solved, per player: for every set of the player's
+  // stones that does not connect, the cells that connect it
+  std::vector<CellMask> connecting[2];
+
+  Solver(const uint64_t positions, const int threads)
+      : answers(solutions_answer_words(positions), 0), possible((positions + 63) / 64),
+        boards(threads), solved(0) {
+    for (std::atomic<uint64_t> &word : possible) {
+      word = 0;
+    }
+  }
+
+  void prepare_size(const int size) {
+    const int count = size * size;
+    const KernelTable *kernels = kernels_for_size(size);
+    for (Player player : {RED, BLUE}) {
+      std::vector<CellMask> &table = connecting[player == BLUE];
+      table.assign((size_t)1 << count, 0);
+      for (CellMask own = 0; own < table.size(); own++) {
+        if (kernels->connected(to_bits(own), player)) {
+          continue;
+        }
+        for (int id = 0; id < count; id++) {
+          CellMask with = own | (CellMask)1 << id;
+          if (with != own && kernels->connected(to_bits(with), player)) {
+            table[own] |= (CellMask)1 << id;
+          }
+        }
+      }
+    }
+  }
+
+  // every position of the size whose high cells are `high`, in base 3
+  void solve_part(Board &board, const int size, const int high_cells,
+                  const int high) {
+    const int count = size * size;
+    const int low_cells = count - high_cells;
+    int digits[SOLUTIONS_MAX_CELLS];
+    for (int i = 0; i < high_cells; i++) {
+      digits[low_cells + i] = high / pow3(i) % 3;
+    }
+    for (int low = 0; low < pow3(low_cells); low++) {
+      int red_count = 0;
+      int blue_count = 0;
+      uint8_t packed[(SOLUTIONS_MAX_CELLS + 3) / 4] = {};
+      for (int id = 0; id < count; id++) {
+        if (id < low_cells) {
+          digits[id] = low / pow3(id) % 3;
+        }
+        red_count += digits[id] == RED;
+        blue_count += digits[id] == BLUE;
+        packed[id >> 2] |= digits[id] << ((id & 3) * 2);
+      }
+      if (red_count != blue_count && red_count != blue_count + 1) {
+        continue;
+      }
+      board.unpack(size, packed);
+      solve_position(board);
+    }
+  }
+
+  void solve_position(Board &board) {
+    int64_t index = solution_index(board);
+    if (board.is_board_possible()) {
+      possible[index / 64].fetch_or(1ull << (index % 64));
+    }
+    uint32_t bits = naive_answers(board);
+    for (int moves = 1; moves <= SOLUTIONS_MAX_MOVES; moves++) {
+      for (Player player : {RED, BLUE}) {
+        if (board.can_player_win_in_n_moves(player, moves, true)) {
+          bits |= 1u << cache_query_bit(player == RED, moves, true);
+        }
+      }
+    }
+    answers[index] = bits;
+    solved++;
+  }
+
+  // the naive opponent queries without searching: the player wins in
+  // exactly n moves if it can add n - 1 stones that do not connect it and
+  // then any empty one that does, with room for the opponent's moves in
+  // between; those never connect the opponent, as the player's stones
+  // connect in the end, so which cells the opponent takes does not matter
+  uint32_t naive_answers(Board &board) {
+    if (board.is_player_connected(RED) || board.is_player_connected(BLUE)) {
+      return 0;
+    }
+    CellMask stones[2] = {0, 0};
+    CellMask empty = 0;
+    for (int id = 0; id < board.size * board.size; id++) {
+      if (board.cells[id] == NONE) {
+        empty |= (CellMask)1 << id;
+      } else {
+        stones[board.cells[id] == BLUE] |= (CellMask)1 << id;
+      }
+    }
+    const int empty_count = __builtin_popcount(empty);
+
+    uint32_t bits = 0;
+    for (Player player : {RED, BLUE}) {
+      const std::vector<CellMask> &table = connecting[player == BLUE];
+      const CellMask own = stones[player == BLUE];
+      // bit k: some k stones leave a connecting cell
+      uint32_t added = 0;
+      for (CellMask sub = empty;; sub = (sub - 1) & empty) {
+        int k = __builtin_popcount(sub);
+        if (k < SOLUTIONS_MAX_MOVES && !(added >> k & 1) &&
+            (table[own | sub] & empty & ~sub) != 0) {
+          added |= 1u << k;
+        }
+        if (sub == 0) {
+          break;
+        }
+      }
+      for (int moves = 1; moves <= SOLUTIONS_MAX_MOVES; moves++) {
+        int op_moves = board.curr_turn() == player ? moves - 1 : moves;
+        if ((added >> (moves - 1) & 1) && empty_count >= moves + op_moves) {
+          bits |= 1u << cache_query_bit(player == RED, moves, false);
+        }
+      }
+    }
+    return bits;
+  }
+
+  static Bitboard to_bits(const CellMask mask) {
+    Bitboard bits = 0;
+    for (CellMask rest = mask; rest; rest &= rest - 1) {
+      bits |= bb_bit(__builtin_ctz(rest));
+    }
+    return bits;
+  }
+
+  static int pow3(const int exp) {
+    int value = 1;
+    for (int i = 0; i < exp; i++) {
+      value *= 3;
+    }
+    return value;
+  }
+};
+
+static bool write_file(const char *path, const Solver &solver,
+                       const uint64_t (&first)[SOLUTIONS_MAX_SIZE + 2]) {
+  SolutionsHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = SOLUTIONS_MAGIC;
+  header.version = SOLUTIONS_VERSION;
+  header.max_size = SOLUTIONS_MAX_SIZE;
+  header.max_moves = SOLUTIONS_MAX_MOVES;
+  memcpy(header.first, first, sizeof(header.first));
+
+  std::vector<uint64_t> possible(solver.possible.size());
+  for (size_t i = 0; i < possible.size(); i++) {
+    possible[i] = solver.possible[i];
+  }
+
+  // written next to the file and renamed, so main never maps half of it
+  std::string tmp = std::string(path) + ".tmp";
+  FILE *file = fopen(tmp.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  bool written =
+      fwrite(&header, sizeof(header), 1, file) == 1 &&
+      fwrite(solver.answers.data(), sizeof(uint32_t), solver.answers.size(),
+             file) == solver.answers.size() &&
+      fwrite(possible.data(), sizeof(uint64_t), possible.size(), file) ==
+          possible.size();
+  written = fclose(file) == 0 && written;
+  return written && rename(tmp.c_str(), path) == 0;
+}
+
+static uint64_t now_ms() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// solves every correct position up to SOLUTIONS_MAX_SIZE and writes the
+// answers for main -D; the perfect opponent queries and IS_BOARD_POSSIBLE
+// are answered by the search of main, see Solver::naive_answers for the
+// rest
+int main(int argc, char **argv) {
+  const char *path = "solutions.db";
+  int threads = 1;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      path = argv[++i];
+    } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+    } else {
+      threads = 0;
+      break;
+    }
+  }
+  if (threads <= 0) {
+    fprintf(stderr, "usage: %s [-o solutions.db] [-t threads]\n", argv[0]);
+    return 1;
+  }
+
+  uint64_t first[SOLUTIONS_MAX_SIZE + 2];
+  solutions_layout(first);
+  const uint64_t positions = first[SOLUTIONS_MAX_SIZE + 1];
+  Solver solver(positions, threads);
+  ThreadPool pool(threads);
+
+  for (int size = 1; size <= SOLUTIONS_MAX_SIZE; size++) {
+    uint64_t start = now_ms();
+    solver.prepare_size(size);
+    int high_cells = std::min(size * size, SPLIT_CELLS);
+    for (int high = 0; high < Solver::pow3(high_cells); high++) {
+      pool.submit([&solver, size, high_cells, high](int w) {
+        solver.solve_part(solver.boards[w], size, high_cells, high);
+      });
+    }
+    pool.wait();
+    fprintf(stderr, "size %d: %llu positions, %.1f s\n", size,
+            (unsigned long long)(first[size + 1] - first[size]),
+            (now_ms() - start) / 1000.0);
+  }
+
+  // every index is hit once, or the numbering is off
+  if (solver.solved != positions) {
+    fprintf(stderr, "solved %llu positions of %llu\n",
+            (unsigned long long)solver.solved.load(),
+            (unsigned long long)positions);
+    return 1;
+  }
+  if (!write_file(path, solver, first)) {
+    perror(path);
+    return 1;
+  }
+  return 0;
+}
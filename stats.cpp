@@ -0,0 +1,283 @@
+#include "stats.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <mutex>
+#include <new>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// counted per thread, a command runs on a single thread
+static thread_local uint64_t thread_allocations = 0;
+
+#if USE_STATS
+void *operator new(size_t size) {
+  thread_allocations++;
+  void *ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+#endif
+
+static uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void LatencyHistogram::add(const uint64_t ns) {
+  int bucket = 63 - __builtin_clzll(ns | 1);
+  if (bucket >= HISTOGRAM_BUCKETS) {
+    bucket = HISTOGRAM_BUCKETS - 1;
+  }
+  buckets[bucket]++;
+  count++;
+  total_ns += ns;
+  if (ns > max_ns) {
+    max_ns = ns;
+  }
+}
+
+Stats::Stats() { clear(); }
+
+void Stats::clear() { memset((void *)this, 0, sizeof(*this)); }
+
+void Stats::add(const Stats &other) {
+  p_turn_nodes += other.p_turn_nodes;
+  op_turn_nodes += other.op_turn_nodes;
+  tt_hits += other.tt_hits;
+  winning_move_scans += other.winning_move_scans;
+  vc_proofs += other.vc_proofs;
+  pruned_replies += other.pruned_replies;
+  distance_cutoffs += other.distance_cutoffs;
+  pruned_moves += other.pruned_moves;
+  cutoffs += other.cutoffs;
+  cutoff_moves_tried += other.cutoff_moves_tried;
+  cache_hits += other.cache_hits;
+  solution_hits += other.solution_hits;
+  playouts += other.playouts;
+  dfs_calls += other.dfs_calls;
+  dfs_expanded += other.dfs_expanded;
+  dfs_early_exits += other.dfs_early_exits;
+  flood_fills += other.flood_fills;
+
+  for (int i = 0; i < other.command_count; i++) {
+    const CommandStats &from = other.commands[i];
+    CommandStats &to = command(from.name);
+    for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+      to.latency.buckets[b] += from.latency.buckets[b];
+    }
+    to.latency.count += from.latency.count;
+    to.latency.total_ns += from.latency.total_ns;
+    if (from.latency.max_ns > to.latency.max_ns) {
+      to.latency.max_ns = from.latency.max_ns;
+    }
+    to.allocations += from.allocations;
+    to.cycles += from.cycles;
+    to.cache_misses += from.cache_misses;
+  }
+}
+
+CommandStats &Stats::command(const char *name) {
+  for (int i = 0; i < command_count; i++) {
+    if (strncmp(commands[i].name, name, STATS_NAME_LEN - 1) == 0) {
+      return commands[i];
+    }
+  }
+  if (command_count == STATS_MAX_COMMANDS) {
+    CommandStats &other = commands[STATS_MAX_COMMANDS - 1];
+    strcpy(other.name, "OTHER");
+    return other;
+  }
+  CommandStats &added = commands[command_count++];
+  snprintf(added.name, STATS_NAME_LEN, "%s", name);
+  return added;
+}
+
+void Stats::write_json(FILE *file, const int board_id,
+                       const bool one_line) const {
+  const char *nl = one_line ? " " : "\n";
+  const char *indent = one_line ? "" : "  ";
+  const char *indent2 = one_line ? "" : "    ";
+
+  fprintf(file, "{%s", nl);
+  if (board_id >= 0) {
+    fprintf(file, "%s\"board\": %d,%s", indent, board_id, nl);
+  }
+  fprintf(file,
+          "%s\"p_turn_nodes\": %llu, \"op_turn_nodes\": %llu, "
+          "\"tt_hits\": %llu, \"winning_move_scans\": %llu,%s",
+          indent, (unsigned long long)p_turn_nodes,
+          (unsigned long long)op_turn_nodes, (unsigned long long)tt_hits,
+          (unsigned long long)winning_move_scans, nl);
+  fprintf(file, "%s\"vc_proofs\": %llu, \"pruned_replies\": %llu,%s", indent,
+          (unsigned long long)vc_proofs, (unsigned long long)pruned_replies,
+          nl);
+  fprintf(file,
+          "%s\"distance_cutoffs\": %llu, \"pruned_moves\": %llu, "
+          "\"cache_hits\": %llu, \"playouts\": %llu,%s",
+          indent, (unsigned long long)distance_cutoffs,
+          (unsigned long long)pruned_moves, (unsigned long long)cache_hits,
+          (unsigned long long)playouts, nl);
+  fprintf(file,
+          "%s\"cutoffs\": %llu, \"cutoff_moves_tried\": %llu, "
+          "\"solution_hits\": %llu,%s",
+          indent, (unsigned long long)cutoffs,
+          (unsigned long long)cutoff_moves_tried,
+          (unsigned long long)solution_hits, nl);
+  fprintf(file,
+          "%s\"dfs_calls\": %llu, \"dfs_expanded\": %llu, "
+          "\"dfs_early_exits\": %llu, \"flood_fills\": %llu,%s",
+          indent, (unsigned long long)dfs_calls,
+          (unsigned long long)dfs_expanded,
+          (unsigned long long)dfs_early_exits,
+          (unsigned long long)flood_fills, nl);
+
+  fprintf(file, "%s\"commands\": [%s", indent, nl);
+  for (int i = 0; i < command_count; i++) {
+    const CommandStats &c = commands[i];
+    const LatencyHistogram &h = c.latency;
+    fprintf(file,
+            "%s{\"command\": \"%s\", \"count\": %llu, \"total_ns\": %llu, "
+            "\"max_ns\": %llu, \"allocations\": %llu, \"cycles\": %llu, "
+            "\"cache_misses\": %llu, \"histogram_log2_ns\": [",
+            indent2, c.name, (unsigned long long)h.count,
+            (unsigned long long)h.total_ns, (unsigned long long)h.max_ns,
+            (unsigned long long)c.allocations, (unsigned long long)c.cycles,
+            (unsigned long long)c.cache_misses);
+    // trailing empty buckets are left out
+    int last = HISTOGRAM_BUCKETS - 1;
+    while (last >= 0 && h.buckets[last] == 0) {
+      last--;
+    }
+    for (int b = 0; b <= last; b++) {
+      fprintf(file, "%s%llu", b > 0 ? ", " : "",
+              (unsigned long long)h.buckets[b]);
+    }
+    fprintf(file, "]}%s%s", i + 1 < command_count ? "," : "", nl);
+  }
+  fprintf(file, "%s]%s}\n", indent, nl);
+}
+
+// where the stats go, and the totals of all finished boards
+static struct {
+  std::mutex mutex;
+  FILE *file = stderr;
+  bool per_board = false;
+  bool perf = false;
+  Stats totals;
+} stats_output;
+
+void stats_init(const char *path, const bool per_board, const bool perf) {
+  if (strcmp(path, "-") != 0) {
+    FILE *file = fopen(path, "w");
+    if (file == nullptr) {
+      fprintf(stderr, "can not open %s, stats go to stderr\n", path);
+    } else {
+      stats_output.file = file;
+    }
+  }
+  stats_output.per_board = per_board;
+  stats_output.perf = perf;
+}
+
+void stats_board_done(Stats &stats, const int board_id) {
+  std::lock_guard<std::mutex> lock(stats_output.mutex);
+  if (stats_output.per_board) {
+    stats.write_json(stats_output.file, board_id, true);
+  }
+  stats_output.totals.add(stats);
+  stats.clear();
+}
+
+void stats_finish() {
+  std::lock_guard<std::mutex> lock(stats_output.mutex);
+  stats_output.totals.write_json(stats_output.file, -1, false);
+  fflush(stats_output.file);
+}
+
+// cycles and cache misses of the calling thread, opened on first use
+// stays closed if the kernel does not allow perf_event_open
+struct PerfCounters {
+  bool opened = false;
+  int cycles_fd = -1;
+  int misses_fd = -1;
+
+  static int open_counter(const uint64_t config) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+
+  void open() {
+    opened = true;
+    cycles_fd = open_counter(PERF_COUNT_HW_CPU_CYCLES);
+    misses_fd = open_counter(PERF_COUNT_HW_CACHE_MISSES);
+    if (cycles_fd < 0 || misses_fd < 0) {
+      fprintf(stderr, "perf_event_open failed, no hardware counters\n");
+    }
+  }
+
+  static void start(const int fd) {
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+  static uint64_t stop(const int fd) {
+    uint64_t value = 0;
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd, &value, sizeof(value)) != sizeof(value)) {
+        value = 0;
+      }
+    }
+    return value;
+  }
+
+  ~PerfCounters() {
+    if (cycles_fd >= 0) {
+      close(cycles_fd);
+    }
+    if (misses_fd >= 0) {
+      close(misses_fd);
+    }
+  }
+};
+
+static thread_local PerfCounters perf_counters;
+
+void StatsProbe::start() {
+  if (stats_output.perf) {
+    if (!perf_counters.opened) {
+      perf_counters.open();
+    }
+    PerfCounters::start(perf_counters.cycles_fd);
+    PerfCounters::start(perf_counters.misses_fd);
+  }
+  start_allocations = thread_allocations;
+  start_ns = now_ns();
+}
+
+void StatsProbe::stop(Stats &stats, const char *cmd) {
+  uint64_t ns = now_ns() - start_ns;
+  CommandStats &c = stats.command(cmd);
+  c.latency.add(ns);
+  c.allocations += thread_allocations - start_allocations;
+  if (stats_output.perf) {
+    c.cycles += PerfCounters::stop(perf_counters.cycles_fd);
+    c.cache_misses += PerfCounters::stop(perf_counters.misses_fd);
+  }
+}
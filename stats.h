@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+// counters of the searches and latency histograms of the commands
+// with USE_STATS false every `if (USE_STATS)` is compiled out, make stats
+// builds main with them on
+#ifndef USE_STATS
+#define USE_STATS false
+#endif
+
+// distinct command lines with their own histogram, the rest share the last
+#define STATS_MAX_COMMANDS 32
+#define STATS_NAME_LEN 64
+// bucket i counts latencies in [2^i, 2^(i+1)) ns
+#define HISTOGRAM_BUCKETS 40
+
+struct LatencyHistogram {
+  uint64_t buckets[HISTOGRAM_BUCKETS];
+  uint64_t count;
+  uint64_t total_ns;
+  uint64_t max_ns;
+
+  void add(const uint64_t ns);
+};
+
+struct CommandStats {
+  char name[STATS_NAME_LEN];
+  LatencyHistogram latency;
+  uint64_t allocations;
+  // hardware counters, only with perf counters on
+  uint64_t cycles;
+  uint64_t cache_misses;
+};
+
+struct Stats {
+  // positions visited by search_p_turn / search_op_turn
+  uint64_t p_turn_nodes;
+  uint64_t op_turn_nodes;
+  uint64_t tt_hits;
+  uint64_t winning_move_scans;
+  // CAN_* answered by a virtual connection, and perfect opponent replies
+  // skipped as outside the must-play region
+  uint64_t vc_proofs;
+  uint64_t pruned_replies;
+  // searches cut off as the player needs more stones than moves left, and
+  // player moves skipped as off every short enough path
+  uint64_t distance_cutoffs;
+  uint64_t pruned_moves;
+  // search nodes decided by a move, and the moves tried up to it
+  uint64_t cutoffs;
+  uint64_t cutoff_moves_tried;
+  // CAN_* answered from the result cache
+  uint64_t cache_hits;
+  // CAN_* and IS_BOARD_POSSIBLE answered from the solution table
+  uint64_t solution_hits;
+  // random games played by GENMOVE
+  uint64_t playouts;
+
+  // is_player_connected_from_start, and walks that reached the
+  // destination before running out of cells
+  uint64_t dfs_calls;
+  uint64_t dfs_expanded;
+  uint64_t dfs_early_exits;
+  // bitboard connectivity checks
+  uint64_t flood_fills;
+
+  CommandStats commands[STATS_MAX_COMMANDS];
+  int command_count;
+
+  Stats();
+  void clear();
+  void add(const Stats &other);
+  CommandStats &command(const char *name);
+  void write_json(FILE *file, const int board_id, const bool one_line) const;
+};
+
+// wraps a single command, records its latency, allocations and hardware
+// counters into the stats of the command
+struct StatsProbe {
+  uint64_t start_ns;
+  uint64_t start_allocations;
+
+  void start();
+  void stop(Stats &stats, const char *cmd);
+};
+
+// path "-" is stderr
+// per_board writes the stats of every board as one json line once its
+// queries are answered, perf wraps every command in perf_event_open
+// cycles / cache misses counters
+void stats_init(const char *path, const bool per_board, const bool perf);
+// folds the stats of a finished board into the totals and clears them
+void stats_board_done(Stats &stats, const int board_id);
+// writes the totals of all boards
+void stats_finish();
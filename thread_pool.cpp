@@ -0,0 +1,90 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(const int thread_count)
+    : queues(thread_count), queued(0), pending(0), stopping(false),
+      next_queue(0) {
+  for (int i = 0; i < thread_count; i++) {
+    threads.emplace_back(&ThreadPool::worker_loop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  work_cv.notify_all();
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+int ThreadPool::size() { return threads.size(); }
+
+void ThreadPool::submit(Task task) {
+  push(next_queue++ % queues.size(), std::move(task));
+}
+
+void ThreadPool::submit_local(const int worker, Task task) {
+  push(worker, std::move(task));
+}
+
+void ThreadPool::push(const int worker, Task task) {
+  pending++;
+  {
+    std::lock_guard<std::mutex> lock(queues[worker].mutex);
+    queues[worker].tasks.push_back(std::move(task));
+  }
+  {
+    // taken so a worker can not miss the wakeup between its check and wait
+    std::lock_guard<std::mutex> lock(mutex);
+    queued++;
+  }
+  work_cv.notify_one();
+}
+
+bool ThreadPool::pop(const int worker, Task &task_out) {
+  int count = queues.size();
+  for (int i = 0; i < count; i++) {
+    Queue &queue = queues[(worker + i) % count];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      continue;
+    }
+    if (i == 0) {
+      task_out = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      task_out = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    queued--;
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::worker_loop(const int worker) {
+  while (true) {
+    Task task;
+    if (pop(worker, task)) {
+      task(worker);
+      if (--pending == 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        done_cv.notify_all();
+      }
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    work_cv.wait(lock, [this] { return stopping || queued > 0; });
+    if (stopping) {
+      return;
+    }
+  }
+}
+
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> lock(mutex);
+  done_cv.wait(lock, [this] { return pending == 0; });
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// tasks get the index of the worker that runs them,
+// so they can use per-worker state without locking
+typedef std::function<void(int worker)> Task;
+
+// fixed set of workers with one deque each
+// a worker takes its own newest task first and steals the oldest task
+// of another worker when its deque is empty
+struct ThreadPool {
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::thread> threads;
+  std::vector<Queue> queues;
+
+  std::mutex mutex;
+  std::condition_variable work_cv;
+  std::condition_variable done_cv;
+  // tasks sitting in queues, and tasks not finished yet
+  std::atomic<int> queued;
+  std::atomic<int> pending;
+  bool stopping;
+  // submit may be called from several threads
+  std::atomic<unsigned> next_queue;
+
+  ThreadPool(const int thread_count);
+  ~ThreadPool();
+
+  int size();
+  // from outside the pool, round-robin over the workers
+  void submit(Task task);
+  // from a task, onto the worker's own deque
+  void submit_local(const int worker, Task task);
+  // blocks until every submitted task has finished
+  void wait();
+
+  void push(const int worker, Task task);
+  bool pop(const int worker, Task &task_out);
+  void worker_loop(const int worker);
+};
@@ -0,0 +1,46 @@
+#include "transposition.h"
+
+TranspositionTable::TranspositionTable()
+    : entries(2ull << TT_BITS, TTEntry{0, 0, 0, false}), generation(1) {}
+
+void TranspositionTable::clear() {
+  generation++;
+  if (generation == 0) {
+    // wrapped around, old entries could look current again
+    for (TTEntry &entry : entries) {
+      entry.generation = 0;
+    }
+    generation = 1;
+  }
+}
+
+bool TranspositionTable::probe(const uint64_t key, bool &value_out) {
+  uint64_t bucket = (key & ((1ull << TT_BITS) - 1)) * 2;
+  for (int i = 0; i < 2; i++) {
+    TTEntry &entry = entries[bucket + i];
+    if (entry.generation == generation && entry.key == key) {
+      value_out = entry.value;
+      return true;
+    }
+  }
+  return false;
+}
+
+void TranspositionTable::store(const uint64_t key, const int moves,
+                               const bool value) {
+  uint64_t bucket = (key & ((1ull << TT_BITS) - 1)) * 2;
+  TTEntry &deep = entries[bucket];
+  TTEntry &recent = entries[bucket + 1];
+
+  TTEntry entry = {key, generation, (int16_t)moves, value};
+
+  if (deep.generation != generation || deep.key == key) {
+    deep = entry;
+  } else if (moves >= deep.moves) {
+    // the old deep entry is still worth more than whatever is recent
+    recent = deep;
+    deep = entry;
+  } else {
+    recent = entry;
+  }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// log2 of the number of buckets, every bucket holds two entries
+#define TT_BITS 17
+
+struct TTEntry {
+  uint64_t key;
+  // table generation the entry was stored in, older ones are empty
+  uint32_t generation;
+  int16_t moves;
+  bool value;
+};
+
+// fixed-size transposition table for the CAN_* searches, allocated once
+// every bucket has a depth-preferred slot, which keeps the entry with
+// more moves left (more work to recompute), and an always-replace slot
+struct TranspositionTable {
+  std::vector<TTEntry> entries;
+  uint32_t generation;
+
+  TranspositionTable();
+
+  // O(1), bumps the generation instead of touching the entries
+  void clear();
+
+  bool probe(const uint64_t key, bool &value_out);
+  void store(const uint64_t key, const int moves, const bool value);
+};
@@ -0,0 +1,50 @@
+#include "union_find.h"
+
+void UnionFind::init(const int node_count) {
+  parent.resize(node_count);
+  set_size.resize(node_count);
+  for (int i = 0; i < node_count; i++) {
+    parent[i] = i;
+    set_size[i] = 1;
+  }
+  log.clear();
+  log.reserve(node_count);
+}
+
+int UnionFind::find(int node) {
+  while (parent[node] != node) {
+    node = parent[node];
+  }
+  return node;
+}
+
+bool UnionFind::same(const int a, const int b) { return find(a) == find(b); }
+
+void UnionFind::unite(const int a, const int b) {
+  int root_a = find(a);
+  int root_b = find(b);
+  if (root_a == root_b) {
+    return;
+  }
+  if (set_size[root_a] < set_size[root_b]) {
+    int tmp = root_a;
+    root_a = root_b;
+    root_b = tmp;
+  }
+  parent[root_b] = root_a;
+  set_size[root_a] += set_size[root_b];
+  log.push_back(root_b);
+}
+
+int UnionFind::mark() { return log.size(); }
+
+void UnionFind::undo(const int mark) {
+  while ((int)log.size() > mark) {
+    int child = log.back();
+    log.pop_back();
+
+    int root = parent[child];
+    set_size[root] -= set_size[child];
+    parent[child] = child;
+  }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+
+// disjoint sets with union by size and an undo log
+// there is no path compression, so every union can be rolled back
+struct UnionFind {
+  std::vector<int> parent;
+  std::vector<int> set_size;
+
+  // roots that got attached to another root, oldest first
+  std::vector<int> log;
+
+  void init(const int node_count);
+
+  int find(int node);
+  bool same(const int a, const int b);
+  void unite(const int a, const int b);
+
+  // undo(mark()) rolls back every union made after the mark() call
+  int mark();
+  void undo(const int mark);
+};
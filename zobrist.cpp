@@ -0,0 +1,46 @@
+#include "board.h"
+#include <cstdint>
+
+// fixed seed, so hashes are the same in every run
+static uint64_t splitmix64(uint64_t &state) {
+  uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+struct ZobristKeys {
+  uint64_t cells[MAX_CELLS][2];
+  uint64_t players[2];
+  uint64_t perfect_op;
+  uint64_t moves;
+
+  ZobristKeys() {
+    uint64_t state = 0x2545f4914f6cdd1dull;
+    for (int id = 0; id < MAX_CELLS; id++) {
+      cells[id][0] = splitmix64(state);
+      cells[id][1] = splitmix64(state);
+    }
+    players[0] = splitmix64(state);
+    players[1] = splitmix64(state);
+    perfect_op = splitmix64(state);
+    moves = splitmix64(state);
+  }
+};
+
+static const ZobristKeys keys;
+
+uint64_t zobrist_cell(const int id, const Player player) {
+  return keys.cells[id][player == RED ? 0 : 1];
+}
+
+uint64_t zobrist_query(const Player player, const int moves,
+                       const bool perfect_op) {
+  uint64_t key = keys.players[player == RED ? 0 : 1];
+  if (perfect_op) {
+    key ^= keys.perfect_op;
+  }
+  // moves is not bounded, so mix it in instead of using a table
+  uint64_t state = keys.moves ^ (uint64_t)moves;
+  return key ^ splitmix64(state);
+}